@@ -28,9 +28,16 @@
 #include <deque>
 #include <queue>
 #include <memory>
+#include <unordered_map>
 #include <iostream>
+#include <stdexcept>
 #include "internal/antichain.h"
+#include "internal/macrostate.h"
+#include "internal/post_cache.h"
+#include "b_context.h"
+#include "internal/frontier.h"
 #include "results.h"
+#include "simulation.h"
 #include "internal/helpers.h"
 
 /**
@@ -48,6 +55,11 @@ namespace Limi {
   * 
   * The algorithm is faster than \ref antichain_algo_ind and is guaranteed to terminate.
   * 
+  * If forward simulations of A and B are given, pairs are compared with the simulations (see \ref internal::antichain)
+  * and every macrostate of B only keeps the states that are not simulated by another state of the macrostate.
+  * 
+  * The pairs are explored depth-first unless another order is chosen with set_search_order().
+  * 
   * @tparam ImplementationA The implementation class of Automaton A
   * @tparam ImplementationB The implementation class of Automaton B
   * 
@@ -60,62 +72,206 @@ class antichain_algo
   using StateB = typename ImplementationB::State_;
   
   using StateA_vector = std::vector<StateA>;
+  using StateB_vector = std::vector<StateB>;
   using StateB_set = std::unordered_set<StateB>;
-  using StateBI_set = std::shared_ptr<const StateB_set>;
+  using StateB_store = internal::macrostate_store<StateB>;
+  using StateBI_set = typename StateB_store::pstate;
   using Symbol_set = std::unordered_set<Symbol>;
   using Symbol_vector = std::vector<Symbol>;
   using AutomatonA = automaton<StateA, Symbol, ImplementationA>;
   using AutomatonB = automaton<StateB, Symbol, ImplementationB>;
+  using SimulationA = simulation<StateA>;
+  using SimulationB = simulation<StateB>;
   
-  using counter_chain = counterexample_chain<Symbol>;
-  using pcounter_chain = std::shared_ptr<counter_chain>;
+  using trace_arena = counterexample_arena<Symbol>;
+  using context_b = b_context<ImplementationB>;
         
   struct pair {
     StateA a;
     StateBI_set b;
-    pair(StateA a, StateBI_set b) : a(a), b(b), cex_chain(nullptr) {}
-    pair(StateA a, StateBI_set b, const pcounter_chain& parent, const Symbol& sym) : pair(a,b)
-    {
-      cex_chain = std::make_shared<counter_chain>(sym, parent);
-    }
-    pcounter_chain cex_chain;
+    unsigned trace; // the path to this pair in traces
+    pair(StateA a, StateBI_set b, unsigned trace = trace_arena::none) : a(a), b(b), trace(trace) {}
   };
   
   using pair_antichain = internal::antichain<StateA, StateB>;
   
-  std::deque<pair> initial_states(const AutomatonA& a, const AutomatonB& b) {
-    std::shared_ptr<StateB_set> states_b = std::make_shared<StateB_set>();
-    b.initial_states(*states_b);
-    std::deque< pair > result;
+  /**
+   * @brief Counts an allocation if a buffer grew beyond its old capacity
+   */
+  template <class Buffer>
+  inline void count_growth(const Buffer& buffer, size_t capacity) {
+    if (buffer.capacity() > capacity) ++statistics.buffer_growths;
+  }
+  
+  void initial_states() {
+    StateBI_set states_b = context.initial();
     for(StateA state_a : a.initial_states()) {
-      pair p(state_a, states_b);
-      result.push_back(p);
+      frontier.push_back(pair(state_a, states_b));
       antichain.add_unchecked(state_a, states_b, false);
     }
-    return result;
   }
   
   const AutomatonA& a;
   const AutomatonB& b;
+  const SimulationA* sim_a;
+  const SimulationB* sim_b;
+  std::unique_ptr<context_b> own_context; // only if no context was passed to the constructor
+  context_b& context;
   pair_antichain antichain;
+  trace_arena traces;
       
-  std::deque<pair> frontier = initial_states(a,b);
+  internal::frontier<pair> frontier;
+  
+  bool incremental = false;
+  std::unordered_map<StateA, std::vector<pair>> expanded; // the pairs whose successors were explored (only if incremental)
+  
+  // buffers reused by every iteration of run()
+  Symbol_vector next_symbols;
+  StateA_vector successors_a;
+  typename inclusion_result<Symbol>::counters statistics;
+  
+  antichain_algo(const AutomatonA& a, context_b* own_context, context_b& context, const SimulationA* sim_a) :
+    a(a), b(context.automaton_b()), sim_a(sim_a), sim_b(context.simulation_b()), own_context(own_context), context(context),
+    antichain(sim_a, sim_b) {
+      initial_states();
+    }
+  
+  static context_b* new_context(const AutomatonB& b, const SimulationB* sim_b, size_t post_cache_size) {
+    return sim_b ? new context_b(b, *sim_b, post_cache_size) : new context_b(b, post_cache_size);
+  }
+  
+  antichain_algo(const AutomatonA& a, context_b* own_context, const SimulationA* sim_a) :
+    antichain_algo(a, own_context, *own_context, sim_a) {}
   
 public:
   
+  /**
+    * @brief A heuristic for \ref search_order::heuristic. Pairs (a,b) with smaller values are explored first.
+    */
+  using heuristic = std::function<unsigned(const StateA&, const StateB_set&)>;
+  
   /**
     * @brief Constructor that initialises the language inclusion algorithm.
     * 
     * @param a The automaton a
     * @param b The automaton b. The b automaton must not produce any epsilon transitions.
+    * @param post_cache_size The maximal number of successor macrostates of b that are cached (0 disables the cache)
     * 
     */
-  antichain_algo(const AutomatonA& a, const AutomatonB& b) :
-    a(a), b(b) {
-      if (!b.collapse_epsilon && !b.no_epsilon_produced) {
-        throw std::logic_error("For the automaton B in the language inclusion algorithm either collapse_epsilon must be true or no_epsilon_produced");
-      }
+  antichain_algo(const AutomatonA& a, const AutomatonB& b, size_t post_cache_size = internal::default_post_cache_size) :
+    antichain_algo(a, new_context(b, nullptr, post_cache_size), nullptr) {}
+  
+  /**
+    * @brief Constructor that initialises the language inclusion algorithm with simulations.
+    * 
+    * The simulations must stay alive as long as the algorithm.
+    * 
+    * @param a The automaton a
+    * @param b The automaton b. The b automaton must not produce any epsilon transitions.
+    * @param simulation_a A forward simulation on the states of a (epsilon is treated as a normal symbol)
+    * @param simulation_b A forward simulation on the states of b
+    * @param post_cache_size The maximal number of successor macrostates of b that are cached (0 disables the cache)
+    * 
+    */
+  antichain_algo(const AutomatonA& a, const AutomatonB& b, const SimulationA& simulation_a, const SimulationB& simulation_b, size_t post_cache_size = internal::default_post_cache_size) :
+    antichain_algo(a, new_context(b, &simulation_b, post_cache_size), &simulation_a) {}
+  
+  /**
+    * @brief Constructor that borrows the macrostates and cached successors of B from a context.
+    * 
+    * The context is updated by the run and can be passed to the next algorithm that checks an automaton against
+    * the same B (see \ref b_context). If the context has a simulation of B it is used like in the constructor with simulations.
+    * 
+    * @param a The automaton a
+    * @param context The context of the automaton b. It must outlive the algorithm.
+    * 
+    */
+  antichain_algo(const AutomatonA& a, context_b& context) :
+    antichain_algo(a, nullptr, context, nullptr) {}
+  
+  /**
+    * @brief Constructor that borrows the context of B and uses a simulation of A.
+    * 
+    * @param a The automaton a
+    * @param context The context of the automaton b. It must outlive the algorithm.
+    * @param simulation_a A forward simulation on the states of a (epsilon is treated as a normal symbol)
+    * 
+    */
+  antichain_algo(const AutomatonA& a, context_b& context, const SimulationA& simulation_a) :
+    antichain_algo(a, nullptr, context, &simulation_a) {}
+  
+  /**
+    * @brief Switches the tracking of counter-examples on or off (it is on by default).
+    * 
+    * Without tracking the algorithm needs less memory, but the counter-example of the result is empty.
+    */
+  void set_track_counter_example(bool track) {
+    traces.set_tracking(track);
+  }
+  
+  /**
+    * @brief Switches the recording of the explored pairs on or off (it is off by default).
+    * 
+    * The recorded pairs are needed by states_changed(), so this must be switched on before the first run()
+    * if the automaton A is going to change. It costs one copy of every explored pair.
+    * 
+    * In incremental mode the pair that produced a counter-example stays in the frontier. A can only grow, so the
+    * word stays a counter-example, and every later run() reports a counter-example again instead of skipping
+    * the pairs behind it. Runs can therefore not be used to enumerate several counter-examples in this mode.
+    */
+  void set_incremental(bool on) {
+    incremental = on;
+    if (!incremental)
+      expanded.clear();
+  }
+  
+  /**
+    * @brief Continues the language inclusion check after automaton A grew.
+    * 
+    * After a run() the automaton A may be changed by adding transitions or final states to states that were already
+    * explored (new states reachable over the new transitions are found anyway). Instead of starting over, the pairs of
+    * the changed states that were already explored are put back into the frontier, and the next call to run()
+    * explores them again with the new transitions. All other pairs are kept. This works after both results:
+    * after Not Included the next run() reports a counter-example again (see set_incremental()).
+    * 
+    * Transitions must not be removed, because pairs found over a removed transition would stay in the antichain.
+    * A simulation of A passed to the constructor must still be a simulation of the changed automaton.
+    * Needs set_incremental() to be switched on before the pairs were explored.
+    * 
+    * @param states The states of A whose outgoing transitions or finality changed
+    */
+  void states_changed(const StateA_vector& states) {
+    if (!incremental)
+      throw std::logic_error("states_changed() needs set_incremental(true) before the run");
+    for (const StateA& state : states) {
+      auto it = expanded.find(state);
+      if (it == expanded.end())
+        continue;
+      // the pairs are recorded again when they are explored
+      for (pair& p : it->second)
+        frontier.push(std::move(p));
+      expanded.erase(it);
     }
+  }
+  
+  /**
+    * @brief Sets the order in which pairs are explored (depth-first by default).
+    * 
+    * Can be called at any time, the pairs that are not explored yet are reordered.
+    * 
+    * @param order The search order
+    * @param h The heuristic, only needed for \ref search_order::heuristic
+    */
+  void set_search_order(search_order order, const heuristic& h = heuristic()) {
+    if (order == search_order::heuristic && !h)
+      throw std::logic_error("The heuristic search order needs a heuristic");
+    if (order == search_order::smallest_first)
+      frontier.set_order(order, [](const pair& p) { return static_cast<unsigned>(p.b->size()); });
+    else if (order == search_order::heuristic)
+      frontier.set_order(order, [h](const pair& p) { return h(p.a, p.b->states()); });
+    else
+      frontier.set_order(order);
+  }
   
   
   /**
@@ -130,40 +286,51 @@ public:
     inclusion_result<Symbol> result;
     result.included = true;
     result.bound_hit = false;
+    statistics = typename inclusion_result<Symbol>::counters();
+    unsigned macrostates_before = context.size();
+    unsigned long growths_before = context.buffer_growths();
+    size_t traces_before = traces.size();
     
 #ifdef DEBUG_PRINTING
     unsigned loop_counter = 0;
     unsigned transitions = 0;
 #endif
-    while (frontier.size() > 0) {
+    while (!frontier.empty()) {
 #ifdef DEBUG_PRINTING
       if (DEBUG_PRINTING>=2 && loop_counter % 1000 == 0) std::cout << loop_counter << " rounds; A states: " << antichain.size() << std::endl;
 #endif
-      pair current = frontier.front();
-      frontier.pop_front();
+      const pair current = frontier.pop();
+      ++statistics.pairs;
       
-      Symbol_vector next_symbols;     
+      size_t capacity = next_symbols.capacity();
+      next_symbols.clear();
       a.next_symbols(current.a, next_symbols);
+      count_growth(next_symbols, capacity);
       
 #ifdef DEBUG_PRINTING
       ++ loop_counter;
 #endif
-      if ((a.is_final_state(current.a) && !b.is_final_state(*current.b))) {
-        result.counter_example = current.cex_chain->to_vector();
+      if ((a.is_final_state(current.a) && !context.is_final(current.b))) {
+        result.counter_example = traces.to_vector(current.trace);
         result.included = false;
+        // a resumed run must not lose the pair and the pairs behind it
+        if (incremental)
+          frontier.push(pair(current));
         break;
       }           
+      if (incremental)
+        expanded[current.a].push_back(current);
       
 #ifdef DEBUG_PRINTING        
       if (DEBUG_PRINTING>=3) {
         std::cout << "Next pair: ";
         std::cout << a.state_printer()(current.a) << " - ";
-        internal::print_set(*current.b, std::cout, b.state_printer());
+        internal::print_set(current.b->states(), std::cout, b.state_printer());
         std::cout << std::endl;
       }    
 #endif
 
-      for (Symbol sigma : next_symbols) {
+      for (const Symbol& sigma : next_symbols) {
 #ifdef DEBUG_PRINTING
         ++transitions;
         if (DEBUG_PRINTING>=4) {
@@ -172,31 +339,32 @@ public:
           std::cout << std::endl;
         }
 #endif
-        StateA_vector states_a = a.successors(current.a, sigma);
-        StateBI_set unpruned;
+        capacity = successors_a.capacity();
+        successors_a.clear();
+        a.successors(current.a, sigma, successors_a);
+        count_growth(successors_a, capacity);
         StateBI_set states_b;
         if (a.is_epsilon(sigma)) states_b=current.b; else {
-          auto states_b1 = std::make_shared<StateB_set>();
-          b.successors(*current.b, sigma, *states_b1);
-          states_b = states_b1;
+          states_b = context.post(current.b, sigma);
         }
                 
-        for (StateA state_a : states_a) {
-          antichain_algo::pair next(state_a, states_b, current.cex_chain, sigma);
-          
-          if (!antichain.contains(next.a, next.b)) {
-            antichain.add(next.a, next.b, false);
-          
-            frontier.push_front(std::move(next));
-          }
+        for (const StateA& state_a : successors_a) {
+          if (antichain.try_add(state_a, states_b, false))
+            frontier.push(pair(state_a, states_b, traces.add(sigma, current.trace)));
         }
         
       }
       
     }
+    statistics.macrostates = context.size() - macrostates_before;
+    statistics.buffer_growths += context.buffer_growths() - growths_before;
+    statistics.traces = traces.size() - traces_before;
+    result.statistics = statistics;
     
 #ifdef DEBUG_PRINTING
     if (DEBUG_PRINTING>=1) std::cout << loop_counter << " rounds; seen states: " << antichain.size() << "; transitions: " << transitions << std::endl;
+    if (DEBUG_PRINTING>=1) std::cout << "macrostates: " << context.size() << "; cached posts: " << context.posts().size() << "; hits: " << context.posts().hits() << "; misses: " << context.posts().misses() << std::endl;
+    if (DEBUG_PRINTING>=1) std::cout << "new macrostates: " << statistics.macrostates << "; trace records: " << statistics.traces << "; buffer growths: " << statistics.buffer_growths << std::endl;
     
     if (DEBUG_PRINTING >= 4) {
       antichain.print(std::cout, a.state_printer(), b.state_printer());
@@ -0,0 +1,254 @@
+/*
+ * Copyright 2016, IST Austria
+ *
+ * This file is part of Limi.
+ *
+ * Limi is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Limi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Limi.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIMI_ANTICHAINALGO_BACKWARD_H
+#define LIMI_ANTICHAINALGO_BACKWARD_H
+
+#include "automaton.h"
+#include <algorithm>
+#include <vector>
+#include <unordered_set>
+#include <memory>
+#include <iostream>
+#include <stdexcept>
+#include "internal/antichain.h"
+#include "internal/macrostate.h"
+#include "internal/post_cache.h"
+#include "internal/frontier.h"
+#include "results.h"
+#include "internal/helpers.h"
+
+namespace Limi {
+
+/**
+  * @brief The antichain algorithm running backwards from the final states (no independence relation)
+  * 
+  * The algorithm explores pairs (a,b) where a is a state of A and b is the set of states of B that accept
+  * the same word as a. It starts with every final state of A paired with the final states of B and follows the
+  * transitions backwards. A counter-example is found when a is initial and b contains no initial state of B.
+  * 
+  * The sets b are kept minimal, which is the same as keeping the complements (the states of B that reject the word)
+  * maximal like in the backward algorithm of De Wulf et al. Which direction explores fewer pairs depends
+  * on the automata, so it can pay off to try both this class and \ref antichain_algo.
+  * 
+  * The transitions are followed backwards with \ref automaton::predecessors() and the pairs are explored on the fly
+  * starting from \ref automaton::final_states(). If an automaton does not implement these functions the default
+  * implementations explore its reachable part once, so then it must be finite. Epsilon transitions of A are
+  * followed backwards without changing the set of B.
+  * 
+  * The class already accepts the automata as constructor arguments and therefore cannot be reused for more
+  * than one language inclusion query. The run() function runs until a counter-example is produced.
+  * Run can be called again to produce another counter-example.
+  * 
+  * @tparam ImplementationA The implementation class of Automaton A
+  * @tparam ImplementationB The implementation class of Automaton B
+  * 
+  */
+template <class ImplementationA, class ImplementationB>
+class antichain_algo_backward
+{
+  using StateA = typename ImplementationA::State_;
+  using Symbol = typename ImplementationA::Symbol_;
+  using StateB = typename ImplementationB::State_;
+  
+  using StateA_vector = std::vector<StateA>;
+  using StateB_vector = std::vector<StateB>;
+  using StateA_set = std::unordered_set<StateA>;
+  using StateB_set = std::unordered_set<StateB>;
+  using StateB_store = internal::macrostate_store<StateB>;
+  using StateBI_set = typename StateB_store::pstate;
+  using Symbol_vector = std::vector<Symbol>;
+  using AutomatonA = automaton<StateA, Symbol, ImplementationA>;
+  using AutomatonB = automaton<StateB, Symbol, ImplementationB>;
+  using trace_arena = counterexample_arena<Symbol>;
+  
+  struct pair {
+    StateA a;
+    StateBI_set b;
+    unsigned trace; // the path from this pair to a final state in traces
+    pair(StateA a, StateBI_set b, unsigned trace = trace_arena::none) : a(a), b(b), trace(trace) {}
+  };
+  
+  using pair_antichain = internal::antichain<StateA, StateB>;
+  
+  /**
+   * @brief Returns the states of B that reach a state of states with sigma (cached)
+   */
+  StateBI_set pre(const StateBI_set& states, const Symbol& sigma) {
+    StateBI_set result;
+    if (posts.find(states->id(), sigma, result))
+      return result;
+    predecessors_b.clear();
+    for (const StateB& state : states->states())
+      b.predecessors(state, sigma, predecessors_b);
+    StateB_set predecessors(predecessors_b.begin(), predecessors_b.end());
+    result = macrostates.intern(std::move(predecessors));
+    posts.insert(states->id(), sigma, result);
+    return result;
+  }
+  
+  /**
+   * @brief Tests if the set contains an initial state of B
+   */
+  inline bool contains_initial(const StateBI_set& states) const {
+    for (const StateB& state : states->states()) {
+      if (initial_b.find(state) != initial_b.end())
+        return true;
+    }
+    return false;
+  }
+  
+  void final_states() {
+    a.initial_states(initial_a);
+    b.initial_states(initial_b);
+    StateB_vector final_b;
+    b.final_states(final_b);
+    StateBI_set states_b = macrostates.intern(StateB_set(final_b.begin(), final_b.end()));
+    for (const StateA& state : a.final_states()) {
+      if (antichain.try_add(state, states_b, false))
+        frontier.push_back(pair(state, states_b));
+    }
+  }
+  
+  const AutomatonA& a;
+  const AutomatonB& b;
+  StateA_set initial_a;
+  StateB_set initial_b;
+  StateB_store macrostates;
+  internal::post_cache<Symbol, StateBI_set> posts;
+  pair_antichain antichain;
+  trace_arena traces;
+  internal::frontier<pair> frontier;
+  
+  // buffers reused by run() and pre()
+  Symbol_vector prev_symbols;
+  StateA_vector predecessors_a;
+  StateB_vector predecessors_b;
+
+public:
+
+  /**
+    * @brief Constructor that initialises the language inclusion algorithm.
+    * 
+    * @param a The automaton a
+    * @param b The automaton b. The b automaton must not produce any epsilon transitions.
+    * @param post_cache_size The maximal number of predecessor macrostates of b that are cached (0 disables the cache)
+    * 
+    */
+  antichain_algo_backward(const AutomatonA& a, const AutomatonB& b, size_t post_cache_size = internal::default_post_cache_size) :
+    a(a), b(b), posts(post_cache_size) {
+      if (!b.collapse_epsilon && !b.no_epsilon_produced) {
+        throw std::logic_error("For the automaton B in the language inclusion algorithm either collapse_epsilon must be true or no_epsilon_produced");
+      }
+      final_states();
+  }
+  
+  /**
+    * @brief Changes the order in which the pairs are explored (see \ref search_order).
+    * 
+    * The smallest_first order takes the pair with the smallest macrostate of B first. The heuristic order is not supported.
+    */
+  void set_search_order(search_order order) {
+    if (order == search_order::heuristic)
+      throw std::logic_error("The backward antichain algorithm does not support a heuristic search order");
+    if (order == search_order::smallest_first)
+      frontier.set_order(order, [](const pair& p) { return static_cast<unsigned>(p.b->size()); });
+    else
+      frontier.set_order(order);
+  }
+  
+  /**
+    * @brief Switches the tracking of counter-examples on or off (it is on by default).
+    * 
+    * Without tracking the algorithm needs less memory, but the counter-example of the result is empty.
+    */
+  void set_track_counter_example(bool track) {
+    traces.set_tracking(track);
+  }
+  
+  /**
+    * @brief Run the language inclusion.
+    * 
+    * Can be called several time to obtain several counter-examples.
+    * 
+    * @return Language inclusion result and a counter-example trace (if applicable)
+    */
+  inclusion_result<Symbol> run()
+  {
+    inclusion_result<Symbol> result;
+    result.included = true;
+    result.bound_hit = false;
+    unsigned macrostates_before = macrostates.size();
+    size_t traces_before = traces.size();
+    
+    while (!frontier.empty()) {
+      const pair current = frontier.pop();
+      ++result.statistics.pairs;
+      
+      if (initial_a.find(current.a) != initial_a.end() && !contains_initial(current.b)) {
+        // the path is stored starting at the final states, so it has to be reversed
+        result.counter_example = traces.to_vector(current.trace);
+        std::reverse(result.counter_example.begin(), result.counter_example.end());
+        result.included = false;
+        break;
+      }
+
+#ifdef DEBUG_PRINTING
+      if (DEBUG_PRINTING>=3) {
+        std::cout << "Next pair: ";
+        std::cout << a.state_printer()(current.a) << " - ";
+        internal::print_set(current.b->states(), std::cout, b.state_printer());
+        std::cout << std::endl;
+      }
+#endif
+
+      prev_symbols.clear();
+      a.prev_symbols(current.a, prev_symbols);
+      for (const Symbol& sigma : prev_symbols) {
+        predecessors_a.clear();
+        a.predecessors(current.a, sigma, predecessors_a);
+        if (predecessors_a.empty())
+          continue;
+        StateBI_set states_b = a.is_epsilon(sigma) ? current.b : pre(current.b, sigma);
+        for (const StateA& state_a : predecessors_a) {
+          if (antichain.try_add(state_a, states_b, false))
+            frontier.push(pair(state_a, states_b, traces.add(sigma, current.trace)));
+        }
+      }
+    }
+    result.statistics.macrostates = macrostates.size() - macrostates_before;
+    result.statistics.traces = traces.size() - traces_before;
+
+#ifdef DEBUG_PRINTING
+    if (DEBUG_PRINTING>=1) std::cout << result.statistics.pairs << " rounds; seen states: " << antichain.size() << std::endl;
+    if (DEBUG_PRINTING>=1) std::cout << "macrostates: " << macrostates.size() << "; cached posts: " << posts.size() << "; hits: " << posts.hits() << "; misses: " << posts.misses() << std::endl;
+    
+    if (DEBUG_PRINTING >= 4) {
+      antichain.print(std::cout, a.state_printer(), b.state_printer());
+    }
+#endif
+
+    return result;
+  }
+  
+};
+
+}
+
+#endif // LIMI_ANTICHAINALGO_BACKWARD_H
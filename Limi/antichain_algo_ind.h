@@ -30,6 +30,9 @@
 #include <memory>
 #include <iostream>
 #include "internal/antichain.h"
+#include "internal/macrostate.h"
+#include "internal/post_cache.h"
+#include "internal/frontier.h"
 #include "results.h"
 #include "internal/helpers.h"
 #include "internal/meta_automaton.h"
@@ -55,6 +58,8 @@ namespace Limi {
   * In addition increase_bound() can be called to increase the bound. A subsequent call to the run() function
   * will yield a counter-example for the higher bound. This process is incremental.
   * 
+  * The pairs are explored depth-first unless another order is chosen with set_search_order().
+  * 
   * 
   * @tparam ImplementationA The implementation class of Automaton A
   * @tparam InnerImplementationB The implementation class of Automaton B
@@ -73,81 +78,119 @@ class antichain_algo_ind
   using ImplementationB = internal::meta_automaton<InnerImplementationB, Independence>;
   using StateB = typename ImplementationB::StateI;
   using StateA_vector = std::vector<StateA>;
+  using StateB_vector = std::vector<StateB>;
   using StateB_set = std::unordered_set<StateB>;
-  using StateBI_set = std::shared_ptr<const StateB_set>;
+  using StateB_store = internal::macrostate_store<StateB>;
+  using StateBI_set = typename StateB_store::pstate;
   using Symbol_set = std::unordered_set<Symbol>;
   using Symbol_vector = std::vector<Symbol>;
   using AutomatonA = automaton<StateA, Symbol, ImplementationA>;
   using InnerAutomatonB = automaton<InnerStateB, Symbol, InnerImplementationB>;
   using AutomatonB = automaton<StateB, Symbol, ImplementationB>;
     
-  using counter_chain = counterexample_chain<Symbol>;
-  using pcounter_chain = std::shared_ptr<counter_chain>;
+  using trace_arena = counterexample_arena<Symbol>;
       
   struct pair {
     StateA a;
     StateBI_set b;
-    pair(StateA a, StateBI_set b) : a(a), b(b), cex_chain(nullptr) {}
-    pair(StateA a, StateBI_set b, const pcounter_chain& parent, const Symbol& sym) : pair(a,b)
-    {
-      cex_chain = std::make_shared<counter_chain>(sym, parent);
-    }
+    unsigned trace; // the path to this pair in traces
+    pair(StateA a, StateBI_set b, unsigned trace = trace_arena::none) : a(a), b(b), trace(trace) {}
     
     bool dirty = false;
-    pcounter_chain cex_chain;
+    unsigned generation = 0; // a dirty pair is only valid in the generation it was created in
   };
   
   using pair_antichain = internal::antichain<StateA, StateB>;
   
-  void prune(std::shared_ptr<StateB_set>& b, StateBI_set& un_pruned, unsigned k, bool dirty) {
-    for(auto it = b->begin(); it!=b->end(); ) {
-      if ((**it).size() > k) {
-        if (!un_pruned && !dirty) {
-          un_pruned = std::make_shared<StateB_set>(*b);
-        }
-        it = b->erase(it);
-      } else {
-        ++it;
+  StateBI_set prune(const StateBI_set& b, StateBI_set& un_pruned, unsigned k, bool dirty) {
+    bool too_large = false;
+    for(const StateB& state : b->states()) {
+      if (state->size() > k) {
+        too_large = true;
+        break;
       }
     }
+    if (!too_large)
+      return b;
+    if (!dirty)
+      un_pruned = b;
+    pruned_set.clear();
+    for(const StateB& state : b->states()) {
+      if (state->size() <= k)
+        pruned_set.insert(state);
+    }
+    return macrostates.intern(std::move(pruned_set));
   }
   
-  void remove_dirty(std::deque<pair>& frontier) {
-    std::deque<pair> newp;
-    while (!frontier.empty()) {
-      auto& e = frontier.front();
-      if (!e.dirty) {
-        newp.push_back(e);
-      }
-      frontier.pop_front();
-    }
-    frontier = newp;
+  /**
+   * @brief Returns the successor macrostate of states for sigma (cached)
+   */
+  StateBI_set post(const StateBI_set& states, const Symbol& sigma) {
+    StateBI_set result;
+    if (posts.find(states->id(), sigma, result))
+      return result;
+    size_t capacity = successors_b.capacity();
+    successors_b.clear();
+    for (const StateB& state : states->states())
+      b.successors(state, sigma, successors_b);
+    count_growth(successors_b, capacity);
+    // the set is only moved into the store if the macrostate is new
+    successor_set.clear();
+    successor_set.insert(successors_b.begin(), successors_b.end());
+    result = macrostates.intern(std::move(successor_set));
+    posts.insert(states->id(), sigma, result);
+    return result;
+  }
+  
+  /**
+   * @brief Counts an allocation if a buffer grew beyond its old capacity
+   */
+  template <class Buffer>
+  inline void count_growth(const Buffer& buffer, size_t capacity) {
+    if (buffer.capacity() > capacity) ++statistics.buffer_growths;
   }
   
-  std::deque<pair> initial_states(const AutomatonA& a, const AutomatonB& b) {
-    std::shared_ptr<StateB_set> states_b = std::make_shared<StateB_set>();
-    b.initial_states(*states_b);
-    std::deque< pair > result;
+  void initial_states() {
+    StateB_set initial_b;
+    b.initial_states(initial_b);
+    StateBI_set states_b = macrostates.intern(std::move(initial_b));
     for(StateA state_a : a.initial_states()) {
-      pair p(state_a, states_b);
-      result.push_back(p);
+      frontier.push_back(pair(state_a, states_b));
       antichain.add_unchecked(state_a, states_b, false);
     }
-    return result;
   }
   
   const AutomatonA& a;
   ImplementationB b_;
   const AutomatonB& b = b_;
+  StateB_store macrostates;
+  internal::post_cache<Symbol, StateBI_set> posts;
   pair_antichain antichain;
+  trace_arena traces;
   
   unsigned bound = 2;  // bound of the algorithm
+  unsigned generation = 0; // increased with every bound, dirty pairs of older generations are dropped
   const Independence& independence_;
   
   std::deque<pair> before_dirty;
-  std::deque<pair> frontier = initial_states(a,b);    
+  internal::frontier<pair> frontier;
+  
+  // buffers reused by every iteration of run()
+  Symbol_vector next_symbols;
+  StateA_vector successors_a;
+  StateB_vector successors_b;
+  StateB_set successor_set;
+  StateB_set pruned_set;
+  typename inclusion_result<Symbol>::counters statistics;
 public:
   
+  /**
+    * @brief A heuristic for \ref search_order::heuristic. Pairs (a,b) with smaller values are explored first.
+    * 
+    * The states of b are the states of \ref internal::meta_automaton (a state of B with the symbols it still has to match).
+    */
+  using heuristic = std::function<unsigned(const StateA&, const StateB_set&)>;
+  
   /**
     * @brief Constructor that initialises the language inclusion algorithm.
     * 
@@ -155,10 +198,12 @@ public:
     * @param ib The automaton b
     * @param initial_bound The starting bound 
     * @param independence The independence (if there is no default constructor)
+    * @param post_cache_size The maximal number of successor macrostates of b that are cached (0 disables the cache)
     * 
     */
-  antichain_algo_ind(const AutomatonA& a, const InnerAutomatonB& ib, unsigned initial_bound = 2, const Independence& independence = Independence()) :
-    a(a), b_(ib, independence), bound(initial_bound), independence_(independence) {
+  antichain_algo_ind(const AutomatonA& a, const InnerAutomatonB& ib, unsigned initial_bound = 2, const Independence& independence = Independence(), size_t post_cache_size = internal::default_post_cache_size) :
+    a(a), b_(ib, independence), posts(post_cache_size), bound(initial_bound), independence_(independence) {
+      initial_states();
   }
   
   /**
@@ -169,6 +214,36 @@ public:
     return bound;
   }
   
+  /**
+    * @brief Switches the tracking of counter-examples on or off (it is on by default).
+    * 
+    * Without tracking the algorithm needs less memory, but the counter-example of the result is empty.
+    * Then a result that hit the bound cannot be checked for being spurious.
+    */
+  void set_track_counter_example(bool track) {
+    traces.set_tracking(track);
+  }
+  
+  /**
+    * @brief Sets the order in which pairs are explored (depth-first by default).
+    * 
+    * Can be called at any time, the pairs that are not explored yet are reordered.
+    * Breadth-first search finds the shortest counter-examples, which are the cheapest to check for being spurious.
+    * 
+    * @param order The search order
+    * @param h The heuristic, only needed for \ref search_order::heuristic
+    */
+  void set_search_order(search_order order, const heuristic& h = heuristic()) {
+    if (order == search_order::heuristic && !h)
+      throw std::logic_error("The heuristic search order needs a heuristic");
+    if (order == search_order::smallest_first)
+      frontier.set_order(order, [](const pair& p) { return static_cast<unsigned>(p.b->size()); });
+    else if (order == search_order::heuristic)
+      frontier.set_order(order, [h](const pair& p) { return h(p.a, p.b->states()); });
+    else
+      frontier.set_order(order);
+  }
+  
   /**
     * @brief Incleases the bound of the language inclusion check. 
     * 
@@ -179,14 +254,12 @@ public:
     if (new_bound < bound) throw std::logic_error("New bound smaller than old bound.");
     if (new_bound == bound) return;
     bound = new_bound;
+    ++generation;
     antichain.clean_dirty();
     
-    remove_dirty(frontier);
     for (auto& e : before_dirty) {
-      if (!antichain.contains(e.a, e.b)) {
-        frontier.push_back(e);
-        antichain.add(e.a, e.b, false);
-      }
+      if (antichain.try_add(e.a, e.b, false))
+        frontier.push_back(std::move(e));
     }
     before_dirty.clear();
   }
@@ -204,26 +277,35 @@ public:
     result.included = true;
     result.bound_hit = false;
     result.max_bound = bound;
+    statistics = typename inclusion_result<Symbol>::counters();
+    unsigned macrostates_before = macrostates.size();
+    size_t traces_before = traces.size();
     
 #ifdef DEBUG_PRINTING
     unsigned loop_counter = 0;
     unsigned transitions = 0;
 #endif
-    while (frontier.size() > 0) {
+    while (!frontier.empty()) {
+      const pair current = frontier.pop();
+      if (current.dirty && current.generation != generation) {
+        // dirty pair from before the last bound increase
+        continue;
+      }
+      ++statistics.pairs;
 #ifdef DEBUG_PRINTING
       if (DEBUG_PRINTING>=2 && loop_counter % 1000 == 0) std::cout << loop_counter << " rounds; A states: " << antichain.size() << std::endl;
 #endif
-      pair current = frontier.front();
-      frontier.pop_front();
       
-      Symbol_vector next_symbols;     
+      size_t capacity = next_symbols.capacity();
+      next_symbols.clear();
       a.next_symbols(current.a, next_symbols);
+      count_growth(next_symbols, capacity);
       
 #ifdef DEBUG_PRINTING
       ++ loop_counter;
 #endif
-      if ((a.is_final_state(current.a) && !b.is_final_state(*current.b))) {
-        result.counter_example = current.cex_chain->to_vector();
+      if ((a.is_final_state(current.a) && !b.is_final_state(current.b->states()))) {
+        result.counter_example = traces.to_vector(current.trace);
         result.included = false;
         if (current.dirty)
           result.bound_hit = true;
@@ -234,12 +316,12 @@ public:
       if (DEBUG_PRINTING>=3) {
         std::cout << "Next pair: ";
         std::cout << a.state_printer()(current.a) << " - ";
-        internal::print_set(*current.b, std::cout, b.state_printer());
+        internal::print_set(current.b->states(), std::cout, b.state_printer());
         std::cout << std::endl;
       }    
 #endif
 
-      for (Symbol sigma : next_symbols) {
+      for (const Symbol& sigma : next_symbols) {
 #ifdef DEBUG_PRINTING
         ++transitions;
         if (DEBUG_PRINTING>=4) {
@@ -248,32 +330,42 @@ public:
           std::cout << std::endl;
         }
 #endif
-        StateA_vector states_a = a.successors(current.a, sigma);
+        capacity = successors_a.capacity();
+        successors_a.clear();
+        a.successors(current.a, sigma, successors_a);
+        count_growth(successors_a, capacity);
         StateBI_set unpruned;
         StateBI_set states_b;
         if (a.is_epsilon(sigma)) states_b=current.b; else {
-          auto states_b1 = std::make_shared<StateB_set>();
-          b.successors(*current.b, sigma, *states_b1);
-          prune(states_b1, unpruned, bound, current.dirty);
-          states_b = states_b1;
+          states_b = prune(post(current.b, sigma), unpruned, bound, current.dirty);
         }
         
-        for (StateA state_a : states_a) {
-          antichain_algo_ind::pair next(state_a, states_b, current.cex_chain, sigma);
+        for (const StateA& state_a : successors_a) {
+          antichain_algo_ind::pair next(state_a, states_b);
           next.dirty = current.dirty || unpruned;
-          if (unpruned) before_dirty.push_back(antichain_algo_ind::pair(state_a, unpruned, current.cex_chain, sigma));
+          next.generation = generation;
+          // the path is only stored if a pair needs it
+          if (unpruned) {
+            next.trace = traces.add(sigma, current.trace);
+            before_dirty.push_back(antichain_algo_ind::pair(state_a, unpruned, next.trace));
+          }
           
-          if (!antichain.contains(next.a, next.b)) {
-            antichain.add(next.a, next.b, next.dirty);
-            frontier.push_front(std::move(next));
+          if (antichain.try_add(next.a, next.b, next.dirty)) {
+            if (!unpruned) next.trace = traces.add(sigma, current.trace);
+            frontier.push(std::move(next));
           }
         }
       }
       
     }
+    statistics.macrostates = macrostates.size() - macrostates_before;
+    statistics.traces = traces.size() - traces_before;
+    result.statistics = statistics;
     
 #ifdef DEBUG_PRINTING
     if (DEBUG_PRINTING>=1) std::cout << loop_counter << " rounds; seen states: " << antichain.size() << "; transitions: " << transitions << std::endl;
+    if (DEBUG_PRINTING>=1) std::cout << "macrostates: " << macrostates.size() << "; cached posts: " << posts.size() << "; hits: " << posts.hits() << "; misses: " << posts.misses() << std::endl;
+    if (DEBUG_PRINTING>=1) std::cout << "new macrostates: " << statistics.macrostates << "; trace records: " << statistics.traces << "; buffer growths: " << statistics.buffer_growths << std::endl;
     
     if (DEBUG_PRINTING >= 4) {
       antichain.print(std::cout, a.state_printer(), b.state_printer());
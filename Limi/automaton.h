@@ -26,6 +26,8 @@
 #include <ostream> 
 #include <algorithm>
 #include <deque>
+#include <memory>
+#include <mutex>
 #include <iostream>
 #include "generics.h"
 #include "internal/hash.h"
@@ -147,6 +149,57 @@ public:
    */
   bool int_is_epsilon(const Symbol& symbol) const;
   
+  /**
+   * @brief **Optionally Implement** Returns the predecessors of a state.
+   * 
+   * The predecessors must be the inverse of \ref successors() (after epsilons were collapsed if collapse_epsilon is true),
+   * but they may include states that are not reachable from the initial states.
+   * The default implementation explores the reachable part of the automaton the first time it is called and keeps
+   * an index of the reversed transitions. That only works for finite automata. The index is built only once, even if
+   * several threads call the function for the first time at once.
+   * 
+   * @param state The state for which the predecessors should be determined.
+   * @param sigma The symbol of the transitions that lead to state.
+   * @param predecessors The vector where the predecessors should be added. The vector may be empty on function call.
+   */
+  void int_predecessors(const State& state, const Symbol& sigma, State_vector& predecessors) const {
+    const typename reverse_index::transitions* incoming = reverse().find(state);
+    if (!incoming) return;
+    auto it = incoming->find(sigma);
+    if (it == incoming->end()) return;
+    predecessors.insert(predecessors.end(), it->second.begin(), it->second.end());
+  }
+  
+  /**
+   * @brief **Optionally Implement** Returns possible symbols on the incoming edges of a state.
+   * 
+   * Like \ref int_next_symbols() it may return a superset. The default implementation uses the same index as
+   * \ref int_predecessors().
+   * 
+   * @param state The state for which the symbols should be listed.
+   * @param symbols A vector of symbols, where the symbols on the incoming edges of state should be added.
+   */
+  void int_prev_symbols(const State& state, Symbol_vector& symbols) const {
+    const typename reverse_index::transitions* incoming = reverse().find(state);
+    if (!incoming) return;
+    for (const auto& t : *incoming)
+      symbols.push_back(t.first);
+  }
+  
+  /**
+   * @brief **Optionally Implement** Returns the final states.
+   * 
+   * This is only needed by algorithms that run backwards from the final states. Like \ref int_predecessors()
+   * the result may include states that are not reachable. The default implementation returns the reachable
+   * final states found by the exploration that builds the index of \ref int_predecessors().
+   * 
+   * @param states A list of states where the final states must be added.
+   */
+  void int_final_states(State_vector& states) const {
+    const reverse_index& index = reverse();
+    states.insert(states.end(), index.final.begin(), index.final.end());
+  }
+  
   /***********************************************
    * Public functions
    **********************************************/
@@ -282,6 +335,72 @@ public:
     symbols.insert(result.begin(), result.end());
   }
   
+  /**
+   * @brief Returns the predecessors of a state, the states that reach state with the symbol sigma.
+   * 
+   * @param state The state for which the predecessors should be determined.
+   * @param sigma The symbol of the transitions that lead to state.
+   * @param predecessors1 The vector where the predecessors should be added. Need not be empty on function call.
+   */
+  inline void predecessors(const State& state, const Symbol& sigma, State_vector& predecessors1) const {
+    impl().int_predecessors(state, sigma, predecessors1);
+  }
+  
+  /**
+   * @brief Returns the predecessors of a state
+   * 
+   * @param state The state.
+   * @param sigma The symbol of the transitions that lead to state.
+   * @return The predecessors of state for symbol sigma.
+   */
+  inline State_vector predecessors(const State& state, const Symbol& sigma) const {
+    State_vector result;
+    predecessors(state, sigma, result);
+    return result;
+  }
+  
+  /**
+   * @brief Returns possible symbols on the incoming edges of a state.
+   * 
+   * @param state The state for which the symbols should be listed.
+   * @param symbols The symbols are added to this vector. Need not be empty when the function is called.
+   */
+  inline void prev_symbols(const State& state, Symbol_vector& symbols) const {
+    impl().int_prev_symbols(state, symbols);
+  }
+  
+  /**
+   * @brief Returns possible symbols on the incoming edges of a state.
+   * 
+   * @param state The state.
+   * @return The symbols on the incoming edges of state
+   */
+  inline Symbol_vector prev_symbols(const State& state) const {
+    Symbol_vector result;
+    prev_symbols(state, result);
+    return result;
+  }
+  
+  /**
+   * @brief Returns the final states.
+   * 
+   * @param states The final states are added to this vector. Need not be empty when the function is called.
+   */
+  inline void final_states(State_vector& states) const {
+    impl().int_final_states(states);
+  }
+  
+  /**
+   * @brief Returns the final states.
+   * 
+   * @return The final states
+   */
+  inline State_vector final_states() const {
+    State_vector result;
+    final_states(result);
+    return result;
+  }
+  
   /**
    * @brief Returns a printer for states.
    * 
@@ -349,9 +468,74 @@ public:
    */
   bool no_epsilon_produced;
 private:
+  // the reversed transitions used by the default int_predecessors
+  struct reverse_index {
+    using transitions = std::unordered_map<Symbol, State_vector>;
+    std::unordered_map<State, transitions> incoming;
+    State_vector final; // the reachable final states
+    
+    inline const transitions* find(const State& state) const {
+      auto it = incoming.find(state);
+      return it == incoming.end() ? nullptr : &it->second;
+    }
+  };
+  
   mutable const printer_base<State>* state_printer_ = nullptr;
   mutable const printer_base<Symbol>* symbol_printer_ = nullptr;
   
+  // the index is built by the first call of reverse(); a copy of the automaton builds its own index
+  struct lazy_reverse_index {
+    std::unique_ptr<std::once_flag> once;
+    std::unique_ptr<reverse_index> index;
+    lazy_reverse_index() : once(new std::once_flag) {}
+    lazy_reverse_index(const lazy_reverse_index&) : lazy_reverse_index() {}
+    lazy_reverse_index& operator=(const lazy_reverse_index&) {
+      once.reset(new std::once_flag);
+      index.reset();
+      return *this;
+    }
+  };
+  mutable lazy_reverse_index reverse_;
+  
+  const reverse_index& reverse() const {
+    std::call_once(*reverse_.once, [this] { reverse_.index.reset(build_reverse()); });
+    return *reverse_.index;
+  }
+  
+  // explores the automaton through the public interface
+  reverse_index* build_reverse() const {
+    reverse_index* index = new reverse_index();
+    State_set seen;
+    std::deque<State> frontier;
+    for (const State& s : initial_states()) {
+      if (seen.insert(s).second)
+        frontier.push_back(s);
+    }
+    Symbol_vector symbols;
+    State_vector succs;
+    while (!frontier.empty()) {
+      State s = frontier.front();
+      frontier.pop_front();
+      if (is_final_state(s))
+        index->final.push_back(s);
+      symbols.clear();
+      next_symbols(s, symbols);
+      for (const Symbol& sigma : symbols) {
+        succs.clear();
+        successors(s, sigma, succs);
+        for (const State& succ : succs) {
+          // all transitions of s are added together, so a duplicate can only be the last predecessor
+          State_vector& preds = index->incoming[succ][sigma];
+          if (preds.empty() || !(preds.back() == s))
+            preds.push_back(s);
+          if (seen.insert(succ).second)
+            frontier.push_back(succ);
+        }
+      }
+    }
+    return index;
+  }
+  
   inline Implementation& impl() {
     return *static_cast<Implementation*>(this);
   }
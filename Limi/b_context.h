@@ -0,0 +1,176 @@
+/*
+ * Copyright 2016, IST Austria
+ *
+ * This file is part of Limi.
+ *
+ * Limi is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Limi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Limi.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIMI_B_CONTEXT_H
+#define LIMI_B_CONTEXT_H
+
+#include "automaton.h"
+#include <vector>
+#include <unordered_set>
+#include <stdexcept>
+#include "internal/macrostate.h"
+#include "internal/post_cache.h"
+#include "simulation.h"
+
+namespace Limi {
+
+/**
+  * @brief The part of the language inclusion check that only depends on the automaton B.
+  * 
+  * \ref antichain_algo determinises B on the fly: it interns the macrostates of B, caches their successors and
+  * tests if they are final. A context keeps all of this, so several queries against the same B can share it.
+  * This pays off if B is fixed and many automata A are checked against it: every \ref antichain_algo constructed
+  * with the context starts with the macrostates and successors the earlier queries computed.
+  * 
+  * The context must outlive the algorithms that use it. It is not thread-safe, so the algorithms that share it
+  * must run one after the other.
+  * 
+  * @tparam ImplementationB The implementation class of Automaton B
+  * 
+  */
+template <class ImplementationB>
+class b_context
+{
+public:
+  using StateB = typename ImplementationB::State_;
+  using Symbol = typename ImplementationB::Symbol_;
+  using StateB_set = std::unordered_set<StateB>;
+  using StateB_store = internal::macrostate_store<StateB>;
+  using StateBI_set = typename StateB_store::pstate;
+  using AutomatonB = automaton<StateB, Symbol, ImplementationB>;
+  using SimulationB = simulation<StateB>;
+  
+  /**
+    * @brief Constructor
+    * 
+    * @param b The automaton b. The b automaton must not produce any epsilon transitions.
+    * @param post_cache_size The maximal number of successor macrostates that are cached (0 disables the cache)
+    */
+  explicit b_context(const AutomatonB& b, size_t post_cache_size = internal::default_post_cache_size) :
+    b_context(b, nullptr, post_cache_size) {}
+  
+  /**
+    * @brief Constructor with a simulation.
+    * 
+    * Every macrostate only keeps the states that are not simulated by another state of the macrostate.
+    * The simulation must stay alive as long as the context.
+    * 
+    * @param b The automaton b. The b automaton must not produce any epsilon transitions.
+    * @param simulation_b A forward simulation on the states of b
+    * @param post_cache_size The maximal number of successor macrostates that are cached (0 disables the cache)
+    */
+  b_context(const AutomatonB& b, const SimulationB& simulation_b, size_t post_cache_size = internal::default_post_cache_size) :
+    b_context(b, &simulation_b, post_cache_size) {}
+  
+  b_context(const b_context&) = delete;
+  b_context& operator=(const b_context&) = delete;
+  
+  /**
+   * @brief Returns the automaton B
+   */
+  inline const AutomatonB& automaton_b() const { return b; }
+  
+  /**
+   * @brief Returns the simulation of B or nullptr
+   */
+  inline const SimulationB* simulation_b() const { return sim_b; }
+  
+  /**
+   * @brief Returns the macrostate of the initial states
+   */
+  inline const StateBI_set& initial() const { return initial_; }
+  
+  /**
+   * @brief Returns the successor macrostate of states for sigma (cached)
+   */
+  StateBI_set post(const StateBI_set& states, const Symbol& sigma) {
+    StateBI_set result;
+    if (posts_.find(states->id(), sigma, result))
+      return result;
+    size_t capacity = successors.capacity();
+    successors.clear();
+    for (const StateB& state : states->states())
+      b.successors(state, sigma, successors);
+    if (successors.capacity() > capacity) ++buffer_growths_;
+    // the set is only moved into the store if the macrostate is new
+    successor_set.clear();
+    successor_set.insert(successors.begin(), successors.end());
+    if (sim_b) sim_b->minimize(successor_set);
+    result = macrostates.intern(std::move(successor_set));
+    posts_.insert(states->id(), sigma, result);
+    return result;
+  }
+  
+  /**
+   * @brief Tests if the macrostate contains a final state (cached)
+   */
+  bool is_final(const StateBI_set& states) {
+    unsigned id = states->id();
+    if (id >= final_.size())
+      final_.resize(macrostates.size(), unknown);
+    if (final_[id] == unknown)
+      final_[id] = b.is_final_state(states->states()) ? accepting : rejecting;
+    return final_[id] == accepting;
+  }
+  
+  /**
+   * @brief The number of macrostates created so far
+   */
+  inline unsigned size() const { return macrostates.size(); }
+  
+  /**
+   * @brief The number of times a scratch buffer had to allocate more memory
+   */
+  inline unsigned long buffer_growths() const { return buffer_growths_; }
+  
+  /**
+   * @brief The cache of successors (for statistics)
+   */
+  inline const internal::post_cache<Symbol, StateBI_set>& posts() const { return posts_; }
+
+private:
+  enum : char { unknown, rejecting, accepting };
+  
+  b_context(const AutomatonB& b, const SimulationB* sim_b, size_t post_cache_size) :
+    b(b), sim_b(sim_b), posts_(post_cache_size) {
+      if (!b.collapse_epsilon && !b.no_epsilon_produced) {
+        throw std::logic_error("For the automaton B in the language inclusion algorithm either collapse_epsilon must be true or no_epsilon_produced");
+      }
+      StateB_set initial_b;
+      b.initial_states(initial_b);
+      if (sim_b) sim_b->minimize(initial_b);
+      initial_ = macrostates.intern(std::move(initial_b));
+  }
+  
+  const AutomatonB& b;
+  const SimulationB* sim_b;
+  StateB_store macrostates;
+  internal::post_cache<Symbol, StateBI_set> posts_;
+  StateBI_set initial_;
+  std::vector<char> final_; // indexed by the id of the macrostate
+  unsigned long buffer_growths_ = 0;
+  
+  // buffers reused by every call of post()
+  std::vector<StateB> successors;
+  StateB_set successor_set;
+};
+
+}
+
+#endif // LIMI_B_CONTEXT_H
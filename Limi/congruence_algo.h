@@ -0,0 +1,278 @@
+/*
+ * Copyright 2016, IST Austria
+ *
+ * This file is part of Limi.
+ *
+ * Limi is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Limi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Limi.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIMI_CONGRUENCE_ALGO_H
+#define LIMI_CONGRUENCE_ALGO_H
+
+#include "automaton.h"
+#include <vector>
+#include <unordered_set>
+#include <unordered_map>
+#include <memory>
+#include <iostream>
+#include <stdexcept>
+#include "internal/macrostate.h"
+#include "internal/post_cache.h"
+#include "internal/frontier.h"
+#include "results.h"
+#include "internal/helpers.h"
+
+namespace Limi {
+
+/**
+  * @brief Language inclusion with bisimulation up to congruence (no independence relation)
+  * 
+  * This is the algorithm of the tool HKC by Bonchi and Pous. Both automata are determinised on the fly and
+  * the algorithm explores pairs (X,Y) of a macrostate X of A and a macrostate Y of B. L(A) is included in L(B)
+  * iff X+Y and Y accept the same language for all reachable pairs. A pair is skipped if it follows from the pairs
+  * already explored by congruence closure. Since the states of A and B are disjoint the only rewriting rules are
+  * Y' -> X'+Y' for the explored pairs (X',Y'), so the pair (X,Y) is skipped if X is covered by the union of all X'
+  * whose Y' is a subset of Y. Unlike the antichain of \ref antichain_algo several explored pairs together can
+  * cover a new pair, which can prune a lot more if A is non-deterministic.
+  * 
+  * A counter-example is found when X contains a final state and Y does not.
+  * 
+  * The class already accepts the automata as constructor arguments and therefore cannot be reused for more
+  * than one language inclusion query. The run() function runs until a counter-example is produced.
+  * Run can be called again to produce another counter-example.
+  * 
+  * @tparam ImplementationA The implementation class of Automaton A
+  * @tparam ImplementationB The implementation class of Automaton B
+  * 
+  */
+template <class ImplementationA, class ImplementationB>
+class congruence_algo
+{
+  using StateA = typename ImplementationA::State_;
+  using Symbol = typename ImplementationA::Symbol_;
+  using StateB = typename ImplementationB::State_;
+  
+  using StateA_vector = std::vector<StateA>;
+  using StateB_vector = std::vector<StateB>;
+  using StateA_set = std::unordered_set<StateA>;
+  using StateB_set = std::unordered_set<StateB>;
+  using StateA_store = internal::macrostate_store<StateA>;
+  using StateB_store = internal::macrostate_store<StateB>;
+  using StateAI_set = typename StateA_store::pstate;
+  using StateBI_set = typename StateB_store::pstate;
+  using Symbol_set = std::unordered_set<Symbol>;
+  using Symbol_vector = std::vector<Symbol>;
+  using AutomatonA = automaton<StateA, Symbol, ImplementationA>;
+  using AutomatonB = automaton<StateB, Symbol, ImplementationB>;
+  
+  using trace_arena = counterexample_arena<Symbol>;
+  
+  struct pair {
+    StateAI_set a;
+    StateBI_set b;
+    unsigned trace; // the path to this pair in traces
+    pair(StateAI_set a, StateBI_set b, unsigned trace = trace_arena::none) : a(a), b(b), trace(trace) {}
+  };
+  
+  /**
+   * @brief Returns the successor macrostate of states for sigma (cached)
+   */
+  template <class Automaton, class Store>
+  static typename Store::pstate post(const Automaton& aut, Store& store, internal::post_cache<Symbol, typename Store::pstate>& cache,
+                                     const typename Store::pstate& states, const Symbol& sigma) {
+    typename Store::pstate result;
+    if (cache.find(states->id(), sigma, result))
+      return result;
+    typename Store::b_set successors;
+    aut.successors(states->states(), sigma, successors);
+    result = store.intern(std::move(successors));
+    cache.insert(states->id(), sigma, result);
+    return result;
+  }
+  
+  /**
+   * @brief Tests if the pair follows from the explored pairs by congruence closure
+   * 
+   * Every state of p.a must be in some explored X' whose Y' is a subset of p.b.
+   */
+  bool congruent(const pair& p) {
+    ++query;
+    for (const StateA& state : p.a->states()) {
+      auto it = rules_of.find(state);
+      if (it == rules_of.end())
+        return false;
+      bool covered = false;
+      for (unsigned rule : it->second) {
+        // the subset test of a rule is done at most once per query
+        if (stamp[rule] != query) {
+          stamp[rule] = query;
+          applies[rule] = rules[rule].b->subset_of(*p.b);
+        }
+        if (applies[rule]) {
+          covered = true;
+          break;
+        }
+      }
+      if (!covered)
+        return false;
+    }
+    return true;
+  }
+  
+  /**
+   * @brief Adds an explored pair as a rule of the congruence
+   */
+  void add_rule(const pair& p) {
+    unsigned rule = rules.size();
+    rules.push_back(p);
+    stamp.push_back(0);
+    applies.push_back(false);
+    for (const StateA& state : p.a->states())
+      rules_of[state].push_back(rule);
+  }
+  
+  void initial_states() {
+    StateA_set initial_a;
+    a.initial_states(initial_a);
+    StateB_set initial_b;
+    b.initial_states(initial_b);
+    frontier.push_back(pair(macrostates_a.intern(std::move(initial_a)), macrostates_b.intern(std::move(initial_b))));
+  }
+  
+  const AutomatonA& a;
+  const AutomatonB& b;
+  StateA_store macrostates_a;
+  StateB_store macrostates_b;
+  internal::post_cache<Symbol, StateAI_set> posts_a;
+  internal::post_cache<Symbol, StateBI_set> posts_b;
+  std::vector<pair> rules; // the explored pairs
+  std::unordered_map<StateA, std::vector<unsigned>> rules_of; // the rules whose X' contains the state
+  std::vector<unsigned> stamp; // the last query that tested the rule
+  std::vector<bool> applies; // the result of the subset test of the rule in that query
+  unsigned query = 0;
+  trace_arena traces;
+  internal::frontier<pair> frontier;
+  Symbol_set next_symbols; // buffer for run()
+
+public:
+
+  /**
+    * @brief Constructor that initialises the language inclusion algorithm.
+    * 
+    * @param a The automaton a. It must not produce any epsilon transitions.
+    * @param b The automaton b. The b automaton must not produce any epsilon transitions.
+    * @param post_cache_size The maximal number of successor macrostates of each automaton that are cached (0 disables the cache)
+    * 
+    */
+  congruence_algo(const AutomatonA& a, const AutomatonB& b, size_t post_cache_size = internal::default_post_cache_size) :
+    a(a), b(b), posts_a(post_cache_size), posts_b(post_cache_size) {
+      if (!a.collapse_epsilon && !a.no_epsilon_produced) {
+        throw std::logic_error("For the automaton A in the congruence algorithm either collapse_epsilon must be true or no_epsilon_produced");
+      }
+      if (!b.collapse_epsilon && !b.no_epsilon_produced) {
+        throw std::logic_error("For the automaton B in the language inclusion algorithm either collapse_epsilon must be true or no_epsilon_produced");
+      }
+      initial_states();
+  }
+  
+  /**
+    * @brief Changes the order in which the pairs are explored (see \ref search_order).
+    * 
+    * The smallest_first order takes the pair with the smallest macrostate of B first. The heuristic order is not supported.
+    */
+  void set_search_order(search_order order) {
+    if (order == search_order::heuristic)
+      throw std::logic_error("The congruence algorithm does not support a heuristic search order");
+    if (order == search_order::smallest_first)
+      frontier.set_order(order, [](const pair& p) { return static_cast<unsigned>(p.b->size()); });
+    else
+      frontier.set_order(order);
+  }
+  
+  /**
+    * @brief Switches the tracking of counter-examples on or off (it is on by default).
+    * 
+    * Without tracking the algorithm needs less memory, but the counter-example of the result is empty.
+    */
+  void set_track_counter_example(bool track) {
+    traces.set_tracking(track);
+  }
+  
+  /**
+    * @brief Run the language inclusion.
+    * 
+    * Can be called several time to obtain several counter-examples.
+    * 
+    * @return Language inclusion result and a counter-example trace (if applicable)
+    */
+  inclusion_result<Symbol> run()
+  {
+    inclusion_result<Symbol> result;
+    result.included = true;
+    result.bound_hit = false;
+    unsigned macrostates_before = macrostates_a.size() + macrostates_b.size();
+    size_t traces_before = traces.size();
+    
+    while (!frontier.empty()) {
+      const pair current = frontier.pop();
+      ++result.statistics.pairs;
+      
+      if (congruent(current))
+        continue;
+      
+      if (a.is_final_state(current.a->states()) && !b.is_final_state(current.b->states())) {
+        result.counter_example = traces.to_vector(current.trace);
+        result.included = false;
+        break;
+      }
+
+#ifdef DEBUG_PRINTING
+      if (DEBUG_PRINTING>=3) {
+        std::cout << "Next pair: ";
+        internal::print_set(current.a->states(), std::cout, a.state_printer());
+        std::cout << " - ";
+        internal::print_set(current.b->states(), std::cout, b.state_printer());
+        std::cout << std::endl;
+      }
+#endif
+
+      add_rule(current);
+      
+      next_symbols.clear();
+      for (const StateA& state : current.a->states())
+        a.next_symbols(state, next_symbols);
+      for (const Symbol& sigma : next_symbols) {
+        StateAI_set states_a = post(a, macrostates_a, posts_a, current.a, sigma);
+        if (states_a->size() == 0)
+          continue;
+        StateBI_set states_b = post(b, macrostates_b, posts_b, current.b, sigma);
+        frontier.push(pair(states_a, states_b, traces.add(sigma, current.trace)));
+      }
+    }
+    result.statistics.macrostates = macrostates_a.size() + macrostates_b.size() - macrostates_before;
+    result.statistics.traces = traces.size() - traces_before;
+
+#ifdef DEBUG_PRINTING
+    if (DEBUG_PRINTING>=1) std::cout << result.statistics.pairs << " rounds; rules: " << rules.size() << std::endl;
+    if (DEBUG_PRINTING>=1) std::cout << "macrostates: " << macrostates_a.size() << " + " << macrostates_b.size() << std::endl;
+#endif
+
+    return result;
+  }
+  
+};
+
+}
+
+#endif // LIMI_CONGRUENCE_ALGO_H
@@ -0,0 +1,290 @@
+/*
+ * Copyright 2016, IST Austria
+ *
+ * This file is part of Limi.
+ *
+ * Limi is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Limi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Limi.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIMI_EQUIVALENCE_ALGO_H
+#define LIMI_EQUIVALENCE_ALGO_H
+
+#include "automaton.h"
+#include <vector>
+#include <unordered_set>
+#include <unordered_map>
+#include <memory>
+#include <iostream>
+#include <stdexcept>
+#include "internal/macrostate.h"
+#include "internal/post_cache.h"
+#include "internal/frontier.h"
+#include "results.h"
+#include "internal/helpers.h"
+
+namespace Limi {
+
+/**
+  * @brief Checks if two automata accept the same language (no independence relation)
+  * 
+  * Instead of running \ref antichain_algo twice (A in B and B in A) both inclusions are checked in one exploration.
+  * The algorithm explores pairs (X,Y) of a macrostate X of A and a macrostate Y of B reached by the same word, so the
+  * macrostates and successors of both automata are computed once and shared by both directions. A pair stands for the
+  * pairs (a,Y) with a in X of the inclusion of A in B and the pairs (b,X) with b in Y of the inclusion of B in A.
+  * It is skipped if all of these are subsumed by the antichains of both directions, that is if for every a in X an
+  * explored pair (X',Y') with a in X' and Y' a subset of Y exists, and likewise for every b in Y.
+  * 
+  * The run stops at the first word that is accepted by one automaton but not the other, whichever direction it violates.
+  * 
+  * The class already accepts the automata as constructor arguments and therefore cannot be reused for more
+  * than one query. The run() function runs until a counter-example is produced.
+  * Run can be called again to produce another counter-example.
+  * 
+  * @tparam ImplementationA The implementation class of Automaton A
+  * @tparam ImplementationB The implementation class of Automaton B
+  * 
+  */
+template <class ImplementationA, class ImplementationB>
+class equivalence_algo
+{
+  using StateA = typename ImplementationA::State_;
+  using Symbol = typename ImplementationA::Symbol_;
+  using StateB = typename ImplementationB::State_;
+  
+  using StateA_set = std::unordered_set<StateA>;
+  using StateB_set = std::unordered_set<StateB>;
+  using StateA_store = internal::macrostate_store<StateA>;
+  using StateB_store = internal::macrostate_store<StateB>;
+  using StateAI_set = typename StateA_store::pstate;
+  using StateBI_set = typename StateB_store::pstate;
+  using Symbol_set = std::unordered_set<Symbol>;
+  using AutomatonA = automaton<StateA, Symbol, ImplementationA>;
+  using AutomatonB = automaton<StateB, Symbol, ImplementationB>;
+  
+  using trace_arena = counterexample_arena<Symbol>;
+  
+  struct pair {
+    StateAI_set a;
+    StateBI_set b;
+    unsigned trace; // the path to this pair in traces
+    pair(StateAI_set a, StateBI_set b, unsigned trace = trace_arena::none) : a(a), b(b), trace(trace) {}
+  };
+  
+  /**
+   * @brief The explored pairs indexed by the states of one side, used as the antichain of one direction
+   */
+  template <class State>
+  struct direction {
+    std::unordered_map<State, std::vector<unsigned>> pairs_of; // the explored pairs that contain the state
+    std::vector<unsigned> stamp; // the last query that tested the pair
+    std::vector<bool> subsumes; // the result of the subset test of the pair in that query
+    
+    void add(unsigned index, const std::unordered_set<State>& states) {
+      stamp.push_back(0);
+      subsumes.push_back(false);
+      for (const State& state : states)
+        pairs_of[state].push_back(index);
+    }
+    
+    /**
+     * @brief Tests if every state is in an explored pair whose other side passes the subset test
+     */
+    template <class Subset>
+    bool covered(const std::unordered_set<State>& states, unsigned query, const Subset& subset) {
+      for (const State& state : states) {
+        auto it = pairs_of.find(state);
+        if (it == pairs_of.end())
+          return false;
+        bool found = false;
+        for (unsigned index : it->second) {
+          // the subset test of a pair is done at most once per query
+          if (stamp[index] != query) {
+            stamp[index] = query;
+            subsumes[index] = subset(index);
+          }
+          if (subsumes[index]) {
+            found = true;
+            break;
+          }
+        }
+        if (!found)
+          return false;
+      }
+      return true;
+    }
+  };
+  
+  /**
+   * @brief Returns the successor macrostate of states for sigma (cached)
+   */
+  template <class Automaton, class Store>
+  static typename Store::pstate post(const Automaton& aut, Store& store, internal::post_cache<Symbol, typename Store::pstate>& cache,
+                                     const typename Store::pstate& states, const Symbol& sigma) {
+    typename Store::pstate result;
+    if (cache.find(states->id(), sigma, result))
+      return result;
+    typename Store::b_set successors;
+    aut.successors(states->states(), sigma, successors);
+    result = store.intern(std::move(successors));
+    cache.insert(states->id(), sigma, result);
+    return result;
+  }
+  
+  bool subsumed(const pair& p) {
+    ++query;
+    return a_in_b.covered(p.a->states(), query, [&](unsigned index) { return explored[index].b->subset_of(*p.b); }) &&
+           b_in_a.covered(p.b->states(), query, [&](unsigned index) { return explored[index].a->subset_of(*p.a); });
+  }
+  
+  void add_explored(const pair& p) {
+    unsigned index = explored.size();
+    explored.push_back(p);
+    a_in_b.add(index, p.a->states());
+    b_in_a.add(index, p.b->states());
+  }
+  
+  void initial_states() {
+    StateA_set initial_a;
+    a.initial_states(initial_a);
+    StateB_set initial_b;
+    b.initial_states(initial_b);
+    frontier.push_back(pair(macrostates_a.intern(std::move(initial_a)), macrostates_b.intern(std::move(initial_b))));
+  }
+  
+  const AutomatonA& a;
+  const AutomatonB& b;
+  StateA_store macrostates_a;
+  StateB_store macrostates_b;
+  internal::post_cache<Symbol, StateAI_set> posts_a;
+  internal::post_cache<Symbol, StateBI_set> posts_b;
+  std::vector<pair> explored;
+  direction<StateA> a_in_b;
+  direction<StateB> b_in_a;
+  unsigned query = 0;
+  trace_arena traces;
+  internal::frontier<pair> frontier;
+  Symbol_set next_symbols; // buffer for run()
+
+public:
+
+  /**
+    * @brief Constructor that initialises the language equivalence algorithm.
+    * 
+    * @param a The automaton a. It must not produce any epsilon transitions.
+    * @param b The automaton b. It must not produce any epsilon transitions.
+    * @param post_cache_size The maximal number of successor macrostates of each automaton that are cached (0 disables the cache)
+    * 
+    */
+  equivalence_algo(const AutomatonA& a, const AutomatonB& b, size_t post_cache_size = internal::default_post_cache_size) :
+    a(a), b(b), posts_a(post_cache_size), posts_b(post_cache_size) {
+      if (!a.collapse_epsilon && !a.no_epsilon_produced) {
+        throw std::logic_error("For the automaton A in the equivalence algorithm either collapse_epsilon must be true or no_epsilon_produced");
+      }
+      if (!b.collapse_epsilon && !b.no_epsilon_produced) {
+        throw std::logic_error("For the automaton B in the equivalence algorithm either collapse_epsilon must be true or no_epsilon_produced");
+      }
+      initial_states();
+  }
+  
+  /**
+    * @brief Changes the order in which the pairs are explored (see \ref search_order).
+    * 
+    * The smallest_first order takes the pair with the fewest states first. The heuristic order is not supported.
+    */
+  void set_search_order(search_order order) {
+    if (order == search_order::heuristic)
+      throw std::logic_error("The equivalence algorithm does not support a heuristic search order");
+    if (order == search_order::smallest_first)
+      frontier.set_order(order, [](const pair& p) { return static_cast<unsigned>(p.a->size() + p.b->size()); });
+    else
+      frontier.set_order(order);
+  }
+  
+  /**
+    * @brief Switches the tracking of counter-examples on or off (it is on by default).
+    * 
+    * Without tracking the algorithm needs less memory, but the counter-example of the result is empty.
+    */
+  void set_track_counter_example(bool track) {
+    traces.set_tracking(track);
+  }
+  
+  /**
+    * @brief Run the language equivalence check.
+    * 
+    * Can be called several time to obtain several counter-examples.
+    * 
+    * @return Language equivalence result and a counter-example trace (if applicable)
+    */
+  equivalence_result<Symbol> run()
+  {
+    equivalence_result<Symbol> result;
+    result.equivalent = true;
+    unsigned macrostates_before = macrostates_a.size() + macrostates_b.size();
+    size_t traces_before = traces.size();
+    
+    while (!frontier.empty()) {
+      const pair current = frontier.pop();
+      ++result.statistics.pairs;
+      
+      if (subsumed(current))
+        continue;
+      
+      bool final_a = a.is_final_state(current.a->states());
+      if (final_a != b.is_final_state(current.b->states())) {
+        result.counter_example = traces.to_vector(current.trace);
+        result.equivalent = false;
+        result.in_a = final_a;
+        break;
+      }
+
+#ifdef DEBUG_PRINTING
+      if (DEBUG_PRINTING>=3) {
+        std::cout << "Next pair: ";
+        internal::print_set(current.a->states(), std::cout, a.state_printer());
+        std::cout << " - ";
+        internal::print_set(current.b->states(), std::cout, b.state_printer());
+        std::cout << std::endl;
+      }
+#endif
+
+      add_explored(current);
+      
+      next_symbols.clear();
+      for (const StateA& state : current.a->states())
+        a.next_symbols(state, next_symbols);
+      for (const StateB& state : current.b->states())
+        b.next_symbols(state, next_symbols);
+      for (const Symbol& sigma : next_symbols) {
+        StateAI_set states_a = post(a, macrostates_a, posts_a, current.a, sigma);
+        StateBI_set states_b = post(b, macrostates_b, posts_b, current.b, sigma);
+        frontier.push(pair(states_a, states_b, traces.add(sigma, current.trace)));
+      }
+    }
+    result.statistics.macrostates = macrostates_a.size() + macrostates_b.size() - macrostates_before;
+    result.statistics.traces = traces.size() - traces_before;
+
+#ifdef DEBUG_PRINTING
+    if (DEBUG_PRINTING>=1) std::cout << result.statistics.pairs << " rounds; explored pairs: " << explored.size() << std::endl;
+    if (DEBUG_PRINTING>=1) std::cout << "macrostates: " << macrostates_a.size() << " + " << macrostates_b.size() << std::endl;
+#endif
+
+    return result;
+  }
+  
+};
+
+}
+
+#endif // LIMI_EQUIVALENCE_ALGO_H
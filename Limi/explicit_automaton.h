@@ -0,0 +1,343 @@
+/*
+ * Copyright 2016, IST Austria
+ *
+ * This file is part of Limi.
+ *
+ * Limi is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Limi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Limi.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIMI_EXPLICIT_AUTOMATON_H
+#define LIMI_EXPLICIT_AUTOMATON_H
+
+#include "automaton.h"
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <algorithm>
+#include <utility>
+
+namespace Limi {
+
+/**
+  * @brief An automaton that is stored explicitly with states numbered from 0.
+  *
+  * The constructor explores all reachable states of another automaton and stores its transitions.
+  * Every state is then identified by its index and the original state can be retrieved with \ref state().
+  * The transitions of every state are sorted by the index of the symbol, both forwards and backwards.
+  *
+  * The automaton is seen through the public interface of the original automaton, so if the original automaton
+  * collapses epsilon transitions the explicit automaton has no epsilon transitions.
+  *
+  * The printers of the original automaton are used for printing, so the original automaton must stay alive as
+  * long as this automaton is printed.
+  *
+  * @tparam State The type of states of the original automaton
+  * @tparam Symbol The type of symbols
+  *
+  */
+template <class State, class Symbol>
+class explicit_automaton : public automaton<unsigned, Symbol, explicit_automaton<State, Symbol>> {
+  using base = automaton<unsigned, Symbol, explicit_automaton<State, Symbol>>;
+public:
+  using State_vector = typename base::State_vector;
+  using Symbol_vector = typename base::Symbol_vector;
+
+  /**
+   * @brief A transition to (or from) target with the symbol with index symbol
+   */
+  struct transition {
+    unsigned symbol;
+    unsigned target;
+    transition(unsigned symbol, unsigned target) : symbol(symbol), target(target) {}
+    inline bool operator<(const transition& other) const {
+      return symbol < other.symbol || (symbol == other.symbol && target < other.target);
+    }
+    inline bool operator==(const transition& other) const {
+      return symbol == other.symbol && target == other.target;
+    }
+  };
+  using transition_vector = std::vector<transition>;
+
+  /**
+   * @brief Explores an automaton and stores it explicitly.
+   *
+   * @param aut The automaton to explore
+   */
+  template <class Implementation>
+  explicit explicit_automaton(const automaton<State, Symbol, Implementation>& aut) :
+    base(false, aut.collapse_epsilon || aut.no_epsilon_produced), state_printer_(&aut.state_printer()), symbol_printer_(&aut.symbol_printer()) {
+    std::deque<unsigned> frontier;
+    for (const State& s : aut.initial_states()) {
+      unsigned id = add_state(s, aut.is_final_state(s), frontier);
+      if (!initial_flags_[id]) {
+        initial_flags_[id] = true;
+        initial_.push_back(id);
+      }
+    }
+    while (!frontier.empty()) {
+      unsigned id = frontier.front();
+      frontier.pop_front();
+      State s = states_[id];
+      for (const Symbol& sigma : aut.next_symbols(s)) {
+        unsigned symbol = add_symbol(sigma, aut.is_epsilon(sigma));
+        for (const State& succ : aut.successors(s, sigma)) {
+          unsigned target = add_state(succ, aut.is_final_state(succ), frontier);
+          add_transition(id, symbol, target);
+        }
+      }
+    }
+    finish();
+  }
+
+  /**
+   * @brief Builds an automaton from explicit data.
+   *
+   * This is used to build quotients and other derived automata. Every state of the new automaton
+   * is represented by a state of the original automaton for printing.
+   *
+   * @param states The original state for every state index
+   * @param symbols The symbols, transitions refer to them by index
+   * @param epsilon Which of the symbols are epsilon transitions
+   * @param initial The initial states
+   * @param final The final states
+   * @param transitions The outgoing transitions of every state
+   * @param state_printer The printer for the original states
+   * @param symbol_printer The printer for the symbols
+   */
+  explicit_automaton(const std::vector<State>& states, const std::vector<Symbol>& symbols, const std::vector<bool>& epsilon,
+                     const std::vector<unsigned>& initial, const std::vector<bool>& final, const std::vector<transition_vector>& transitions,
+                     const printer_base<State>& state_printer, const printer_base<Symbol>& symbol_printer) :
+    base(false, std::find(epsilon.begin(), epsilon.end(), true) == epsilon.end()), states_(states), symbols_(symbols), epsilon_(epsilon),
+    initial_(initial), initial_flags_(states.size(), false), final_(final), successors_(transitions),
+    state_printer_(&state_printer), symbol_printer_(&symbol_printer) {
+    for (unsigned i = 0; i < states_.size(); ++i)
+      state_index_.insert(std::make_pair(states_[i], i));
+    for (unsigned i = 0; i < symbols_.size(); ++i)
+      symbol_index_.insert(std::make_pair(symbols_[i], i));
+    for (unsigned i : initial_)
+      initial_flags_[i] = true;
+    finish();
+  }
+
+  explicit_automaton(const explicit_automaton&) = delete;
+  explicit_automaton& operator=(const explicit_automaton&) = delete;
+
+  /**
+   * @brief Returns the number of states
+   */
+  inline unsigned size() const { return states_.size(); }
+
+  /**
+   * @brief Returns the number of different symbols
+   */
+  inline unsigned symbol_count() const { return symbols_.size(); }
+
+  /**
+   * @brief Returns the number of transitions
+   */
+  inline unsigned transition_count() const { return transitions_; }
+
+  /**
+   * @brief Returns the original state of a state index
+   */
+  inline const State& state(unsigned id) const { return states_[id]; }
+
+  /**
+   * @brief Returns the index of an original state.
+   *
+   * @return The index or size() if the state was not reachable.
+   */
+  inline unsigned index(const State& s) const {
+    auto it = state_index_.find(s);
+    return it == state_index_.end() ? size() : it->second;
+  }
+
+  /**
+   * @brief Returns the symbol with index id
+   */
+  inline const Symbol& symbol(unsigned id) const { return symbols_[id]; }
+
+  /**
+   * @brief Returns the index of a symbol.
+   *
+   * @return The index or symbol_count() if the symbol does not occur in the automaton.
+   */
+  inline unsigned symbol_index(const Symbol& sigma) const {
+    auto it = symbol_index_.find(sigma);
+    return it == symbol_index_.end() ? symbol_count() : it->second;
+  }
+
+  /**
+   * @brief Returns true if the symbol with index id is an epsilon transition
+   */
+  inline bool epsilon(unsigned id) const { return epsilon_[id]; }
+
+  /**
+   * @brief Returns true if the state is initial
+   */
+  inline bool is_initial(unsigned id) const { return initial_flags_[id]; }
+
+  /**
+   * @brief Returns the outgoing transitions of a state sorted by symbol
+   */
+  inline const transition_vector& transitions(unsigned id) const { return successors_[id]; }
+
+  /**
+   * @brief Returns the incoming transitions of a state sorted by symbol (target is the source of the transition)
+   */
+  inline const transition_vector& reverse_transitions(unsigned id) const { return predecessors_[id]; }
+
+  /**
+   * @brief Returns the range of the transitions with the symbol with index symbol
+   */
+  static inline std::pair<typename transition_vector::const_iterator, typename transition_vector::const_iterator>
+  symbol_range(const transition_vector& transitions, unsigned symbol) {
+    return std::equal_range(transitions.begin(), transitions.end(), transition(symbol, 0),
+                            [](const transition& t1, const transition& t2) { return t1.symbol < t2.symbol; });
+  }
+
+  inline bool int_is_final_state(const unsigned& state) const { return final_[state]; }
+
+  inline void int_initial_states(State_vector& states) const { states.insert(states.end(), initial_.begin(), initial_.end()); }
+
+  inline void int_successors(const unsigned& state, const Symbol& sigma, State_vector& successors) const {
+    auto it = symbol_index_.find(sigma);
+    if (it == symbol_index_.end()) return;
+    auto range = symbol_range(successors_[state], it->second);
+    for (auto t = range.first; t != range.second; ++t)
+      successors.push_back(t->target);
+  }
+
+  inline void int_next_symbols(const unsigned& state, Symbol_vector& symbols) const {
+    const transition_vector& transitions = successors_[state];
+    for (unsigned i = 0; i < transitions.size(); ++i) {
+      if (i == 0 || transitions[i].symbol != transitions[i-1].symbol)
+        symbols.push_back(symbols_[transitions[i].symbol]);
+    }
+  }
+
+  inline void int_predecessors(const unsigned& state, const Symbol& sigma, State_vector& predecessors) const {
+    auto it = symbol_index_.find(sigma);
+    if (it == symbol_index_.end()) return;
+    auto range = symbol_range(predecessors_[state], it->second);
+    for (auto t = range.first; t != range.second; ++t)
+      predecessors.push_back(t->target);
+  }
+
+  inline void int_prev_symbols(const unsigned& state, Symbol_vector& symbols) const {
+    const transition_vector& transitions = predecessors_[state];
+    for (unsigned i = 0; i < transitions.size(); ++i) {
+      if (i == 0 || transitions[i].symbol != transitions[i-1].symbol)
+        symbols.push_back(symbols_[transitions[i].symbol]);
+    }
+  }
+
+  inline void int_final_states(State_vector& states) const {
+    for (unsigned state = 0; state < final_.size(); ++state) {
+      if (final_[state])
+        states.push_back(state);
+    }
+  }
+
+  inline bool int_is_epsilon(const Symbol& symbol) const {
+    auto it = symbol_index_.find(symbol);
+    return it != symbol_index_.end() && epsilon_[it->second];
+  }
+
+  inline printer_base<unsigned>* int_state_printer() const { return new index_printer(*this); }
+
+  inline printer_base<Symbol>* int_symbol_printer() const { return new forward_printer(*symbol_printer_); }
+
+private:
+  std::vector<State> states_;
+  std::unordered_map<State, unsigned> state_index_;
+  std::vector<Symbol> symbols_;
+  std::unordered_map<Symbol, unsigned> symbol_index_;
+  std::vector<bool> epsilon_;
+  std::vector<unsigned> initial_;
+  std::vector<bool> initial_flags_;
+  std::vector<bool> final_;
+  std::vector<transition_vector> successors_;
+  std::vector<transition_vector> predecessors_;
+  unsigned transitions_ = 0;
+  const printer_base<State>* state_printer_;
+  const printer_base<Symbol>* symbol_printer_;
+
+  // prints a state index as the original state
+  struct index_printer : public printer_base<unsigned> {
+    const explicit_automaton& aut;
+    index_printer(const explicit_automaton& aut) : aut(aut) {}
+    virtual void print(const unsigned& item, std::ostream& out) const override {
+      aut.state_printer_->print(aut.states_[item], out);
+    }
+  };
+
+  struct forward_printer : public printer_base<Symbol> {
+    const printer_base<Symbol>& inner;
+    forward_printer(const printer_base<Symbol>& inner) : inner(inner) {}
+    virtual void print(const Symbol& item, std::ostream& out) const override {
+      inner.print(item, out);
+    }
+  };
+
+  unsigned add_state(const State& s, bool final, std::deque<unsigned>& frontier) {
+    auto it = state_index_.find(s);
+    if (it != state_index_.end())
+      return it->second;
+    unsigned id = states_.size();
+    state_index_.insert(std::make_pair(s, id));
+    states_.push_back(s);
+    initial_flags_.push_back(false);
+    final_.push_back(final);
+    successors_.emplace_back();
+    frontier.push_back(id);
+    return id;
+  }
+
+  unsigned add_symbol(const Symbol& sigma, bool epsilon) {
+    auto it = symbol_index_.find(sigma);
+    if (it != symbol_index_.end())
+      return it->second;
+    unsigned id = symbols_.size();
+    symbol_index_.insert(std::make_pair(sigma, id));
+    symbols_.push_back(sigma);
+    epsilon_.push_back(epsilon);
+    return id;
+  }
+
+  inline void add_transition(unsigned source, unsigned symbol, unsigned target) {
+    successors_[source].emplace_back(symbol, target);
+  }
+
+  // sorts the transitions, removes duplicates and builds the reverse transitions
+  void finish() {
+    predecessors_.assign(states_.size(), transition_vector());
+    transitions_ = 0;
+    for (unsigned s = 0; s < states_.size(); ++s) {
+      transition_vector& transitions = successors_[s];
+      std::sort(transitions.begin(), transitions.end());
+      transitions.erase(std::unique(transitions.begin(), transitions.end()), transitions.end());
+      transitions_ += transitions.size();
+      for (const transition& t : transitions)
+        predecessors_[t.target].emplace_back(t.symbol, s);
+    }
+    // sources are visited in order, so the reverse transitions only need to be sorted by symbol
+    for (transition_vector& transitions : predecessors_)
+      std::stable_sort(transitions.begin(), transitions.end(), [](const transition& t1, const transition& t2) { return t1.symbol < t2.symbol; });
+  }
+};
+
+}
+
+#endif // LIMI_EXPLICIT_AUTOMATON_H
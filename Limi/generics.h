@@ -69,6 +69,24 @@ struct no_independence {
   }
 };
 
+/**
+ * @brief Tells the library if a state class can be mapped to small dense integers.
+ * 
+ * If a state class is dense, sets of such states can be stored as packed bitsets, which makes
+ * subset tests in the antichain much faster. No class is dense by default, not even integral types,
+ * because a negative or large state would allocate a huge bitset. Your class can specialise this
+ * template and set value to true if the states are numbered from 0 upwards without large gaps.
+ * The specialised class must then implement the static function index.
+ * 
+ * Non-dense classes fall back to hash lookups.
+ * 
+ * @tparam Key The type of the states.
+ */
+template< class Key, class Enable = void >
+struct dense_index {
+  static constexpr bool value = false;
+};
+
 /**
  * @brief The printer base is what custom printers need to inherit from.
  *
@@ -26,8 +26,12 @@
 #include <unordered_set>
 #include <algorithm>
 #include <ostream>
+#include <memory>
 #include "../generics.h"
 #include "helpers.h"
+#include "macrostate.h"
+#include "set_antichain.h"
+#include "../simulation.h"
 
 namespace Limi {
   /**
@@ -36,7 +40,7 @@ namespace Limi {
    * These functions are generally not relevant to the users of the library.
    */
   namespace internal {
-  
+
 /**
  * @brief An Antichain of minimal elements
  * 
@@ -45,6 +49,11 @@ namespace Limi {
  * The antichain as an invariant that needs to be maintained by \ref add() as follows: ∀ a1,b1,a2,b2. ¬[(a1,b1) ⊑ (a2,b2)] ∧ ¬[(a2,b2) ⊑ (a1,b1)].
  * 
  * The antichain keeps for each pair (a,b) a dirty flag that tracks if this element is dirty. If it is then it is removed when the antichain_algo restarts.
+ * Optionally the antichain uses forward simulations ⪯ on A and B. Then (a1,b1) ⊑ (a2,b2) iff a2 ⪯ a1 and every state of b1 is
+ * simulated by some state of b2. Without simulations ⪯ is the identity and this reduces to the relation above, a1=a2 ∧ b1 ⊆ b2.
+ * 
+ * Dirty elements are removed lazily: \ref clean_dirty() only starts a new generation and every bucket drops its dirty
+ * elements from older generations the next time it is accessed.
  * 
  * @tparam A The type of elements A
  * @tparam B The type of elements B
@@ -54,34 +63,160 @@ template <class A, class B, class HashA = std::hash<A>, class HashB = std::hash<
 class antichain
 {
 private:
-  typedef std::unordered_set<B, HashB, CompareB> b_set;
+  typedef internal::macrostate<B, HashB, CompareB> b_set;
   typedef std::shared_ptr<const b_set> pb_set;
-  // the datastore contais a list of sets for each element A. The list corresponds to sets
+  typedef simulation<A, HashA, CompareA> simulation_a;
+  typedef simulation<B, HashB, CompareB> simulation_b;
+  
+  typedef set_antichain<B, HashB, CompareB> b_sets;
+  
+  /**
+   * @brief All sets of B's we saw with one element of A, and which of them are dirty.
+   */
+  struct bucket {
+    b_sets sets;
+    std::unordered_set<const b_set*> dirty; // the addresses of the live dirty sets
+    unsigned generation = 0; // the dirty sets were added in this generation
+    
+    void push_back(const pb_set& set, bool is_dirty) {
+      if (sets.insert(set)) {
+        if (is_dirty) dirty.insert(set.get());
+      } else if (!is_dirty) {
+        dirty.erase(set.get());
+      }
+    }
+    
+    /**
+     * @brief Removes the dirty sets if they are from an older generation than current
+     */
+    void refresh(unsigned current) {
+      if (generation == current) return;
+      generation = current;
+      for (const b_set* set : dirty)
+        sets.erase(set);
+      dirty.clear();
+    }
+  };
+  
+  // the datastore contais a bucket of sets for each element A. The list corresponds to sets
   // of B's we saw with A. Further a dirty flag is stored for each set
-  std::unordered_map<A,std::vector<std::pair<pb_set,bool>>, HashA, CompareA> datastore;
+  std::unordered_map<A, bucket, HashA, CompareA> datastore;
+  unsigned generation = 0;
+  const simulation_a* sim_a = nullptr;
+  const simulation_b* sim_b = nullptr;
   
   /**
-   * @brief Tests if set1 is a subset of set2
+   * @brief Returns the bucket of a, creating it if needed
    */
-  inline bool contained(const b_set& set1, const b_set& set2) const {
-    for(auto it=set1.begin(); it!=set1.end(); it++) {
-      if (set2.find(*it) == set2.end())
-        return false;
+  inline bucket& get_bucket(const A& a) {
+    auto it = datastore.find(a);
+    if (it == datastore.end()) {
+      bucket& bu = datastore[a];
+      bu.generation = generation;
+      return bu;
     }
-    return true;
+    it->second.refresh(generation);
+    return it->second;
   }
+  
+  /**
+   * @brief Tests if the set b1 is smaller than b2, that is b1 ⊆ b2 or b1 is simulated by b2
+   */
+  inline bool smaller(const b_set& b1, const b_set& b2) const {
+    if (sim_b)
+      return sim_b->forall_exists(b1.states(), b2.states());
+    return b1.subset_of(b2);
+  }
+  
+  /**
+   * @brief Tests if the bucket of a contains a set smaller than b
+   */
+  bool contains_smaller(const A& a, const b_set& b) {
+    auto it = datastore.find(a);
+    if (it == datastore.end())
+      return false;
+    bucket& bu = it->second;
+    bu.refresh(generation);
+    if (!sim_b || bu.sets.stored(b))
+      return bu.sets.contains_subset(b);
+    return bu.sets.any_of([&](const b_set& b1) { return smaller(b1, b); });
+  }
+  
+  /**
+   * @brief Removes all sets larger than b from the bucket of a
+   */
+  void remove_larger(const A& a, const b_set& b) {
+    auto it = datastore.find(a);
+    if (it == datastore.end())
+      return;
+    bucket& bu = it->second;
+    bu.refresh(generation);
+    bu.sets.remove_if([&](const b_set& b1) { return smaller(b, b1); }, [&](const b_set* b1) { bu.dirty.erase(b1); });
+  }
+  
+  /**
+   * @brief Tests if the antichain contains an element smaller than (a,b) with respect to the simulations
+   */
+  bool contains_simulated(const A& a, const b_set& b) {
+    if (contains_smaller(a, b))
+      return true;
+    if (sim_a) {
+      for (const A& a1 : sim_a->simulators(a)) {
+        if (contains_smaller(a1, b))
+          return true;
+      }
+    }
+    return false;
+  }
+  
 public:
   antichain() = default;
   
+  /**
+   * @brief Creates an antichain that compares elements with simulations.
+   * 
+   * @param sim_a A forward simulation on A or nullptr for the identity
+   * @param sim_b A forward simulation on B or nullptr for the identity
+   */
+  antichain(const simulation_a* sim_a, const simulation_b* sim_b) : sim_a(sim_a), sim_b(sim_b) {}
+  
   /**
    * @brief Add to the antichain an element without checking if the invariant is preserved
    * 
    */
   inline void add_unchecked(const A& a, const pb_set& b, bool dirty = false) {
-    datastore[a].push_back(std::make_pair(b, dirty));
+    get_bucket(a).push_back(b, dirty);
   }
   
   
+  /**
+   * @brief Adds (a,b) to the antichain unless it contains a smaller element.
+   * 
+   * This is \ref contains() followed by \ref add(), but a is looked up once and the subsets of b and the
+   * supersets of b are searched in one pass over the bucket (the groups up to the size of b and the ones above).
+   * 
+   * @returns True if (a,b) was added, false if there is any a1,b1 in the antichain, such that (a1,b1) ⊑ (a,b)
+   */
+  bool try_add(const A& a, const pb_set& b, bool dirty = false) {
+    if (sim_a || sim_b) {
+      if (contains_simulated(a, *b))
+        return false;
+      remove_larger(a, *b);
+      if (sim_a) {
+        for (const A& a1 : sim_a->simulated(a))
+          remove_larger(a1, *b);
+      }
+      get_bucket(a).push_back(b, dirty);
+      return true;
+    }
+    bucket& bu = get_bucket(a);
+    if (!bu.sets.try_insert(b, [&](const b_set* b1) { bu.dirty.erase(b1); }))
+      return false;
+    if (dirty)
+      bu.dirty.insert(b.get());
+    return true;
+  }
+  
   /**
    * @brief Add element (a,b) to the antichain.
    * 
@@ -89,23 +224,8 @@ public:
    * and by not adding (a,b) if there is any a1,b1 (a1,b1) ⊑ (a,b)
    * 
    */
-  void add(const A& a, const pb_set& b, bool dirty = false) {
-    std::vector<std::pair<pb_set,bool>>& b_sets = datastore[a];
-    bool found = false;
-    for (auto it = b_sets.begin(); it != b_sets.end();) {
-      // the smallest subset should stay in
-      if (contained(*it->first, *b)) {
-        found = true;
-        break;
-      }
-      if (contained(*b, *it->first)) {
-        it = b_sets.erase(it);
-      } else {
-        it++;
-      }
-    }
-    if (!found)
-      b_sets.push_back(std::make_pair(b,dirty));
+  inline void add(const A& a, const pb_set& b, bool dirty = false) {
+    try_add(a, b, dirty);
   }
   
   /**
@@ -113,15 +233,14 @@ public:
    * 
    * @returns True if there is any a1,b1 in the antichain, such that (a1,b1) ⊑ (a,b)
    */
-  bool contains(const A& a, const pb_set& b) const {
+  bool contains(const A& a, const pb_set& b) {
+    if (sim_a || sim_b)
+      return contains_simulated(a, *b);
     auto b_sets = datastore.find(a);
     if (b_sets == datastore.end())
       return false;
-    for (auto it = b_sets->second.begin(); it != b_sets->second.end(); it++) {
-      if (contained(*it->first, *b))
-        return true;
-    }
-    return false;
+    b_sets->second.refresh(generation);
+    return b_sets->second.sets.contains_subset(*b);
   }
   
   /**
@@ -135,11 +254,11 @@ public:
   
   /**
    * @brief Remove elements marked as dirty
+   * 
+   * This takes constant time. The elements are dropped the next time their bucket is accessed.
    */
-  void clean_dirty() {
-    for(std::pair<const A,std::vector<std::pair<pb_set,bool>>>& ds : datastore) {
-      ds.second.erase(std::remove_if( ds.second.begin(), ds.second.end(), [](std::pair<pb_set,bool> el) { return el.second; } ), ds.second.end());
-    }
+  inline void clean_dirty() {
+    ++generation;
   }
   
   
@@ -151,14 +270,18 @@ public:
    * @param printerB The state printer for states of type B
    */
   void print(std::ostream& out, const printer_base<A>& printerA = printer<A>(), const printer_base<B>& printerB = printer<B>()) const {
-    for(const std::pair<A,std::vector<std::pair<pb_set,bool>>>& ds : datastore) {
+    for(const std::pair<const A,bucket>& ds : datastore) {
       out << "For element " << printerA(ds.first) << std::endl;
-      for (const std::pair<pb_set,bool>& set1 : ds.second) {
+      const bucket& bu = ds.second;
+      bool stale = bu.generation != generation;
+      bu.sets.for_each([&](const pb_set& set1) {
+        bool dirty = bu.dirty.find(set1.get()) != bu.dirty.end();
+        if (dirty && stale) return;
         out << "  ";
-        print_set(*set1.first, out, printerB);
-        if (set1.second) out << "_d";
+        print_set(set1->states(), out, printerB);
+        if (dirty) out << "_d";
         out << std::endl;
-      }
+      });
     }
   }
 };
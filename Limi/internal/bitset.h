@@ -0,0 +1,91 @@
+/*
+ * Copyright 2016, IST Austria
+ *
+ * This file is part of Limi.
+ *
+ * Limi is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Limi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Limi.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIMI_INTERNAL_BITSET_H
+#define LIMI_INTERNAL_BITSET_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace Limi {
+namespace internal {
+
+/**
+ * @brief A set of small integers stored as a packed bitset.
+ * 
+ * The set grows as needed. Trailing zero words are never stored, so two sets that contain
+ * the same elements also have the same number of words.
+ * 
+ */
+class packed_set {
+  std::vector<uint64_t> words_;
+public:
+  packed_set() = default;
+
+  /**
+   * @brief Builds the bitset from a range of elements.
+   * 
+   * @param first The first element
+   * @param last The end of the range
+   * @param index A function that maps the elements to integers
+   */
+  template <class It, class Index>
+  packed_set(It first, It last, Index index) {
+    for (; first != last; ++first)
+      insert(index(*first));
+  }
+
+  inline void insert(size_t i) {
+    size_t word = i >> 6;
+    if (word >= words_.size())
+      words_.resize(word + 1, 0);
+    words_[word] |= uint64_t(1) << (i & 63);
+  }
+
+  inline bool contains(size_t i) const {
+    size_t word = i >> 6;
+    return word < words_.size() && (words_[word] >> (i & 63)) & 1;
+  }
+
+  /**
+   * @brief Tests if this set is a subset of other.
+   * 
+   * The loop has no early exit so that the compiler can vectorise it.
+   */
+  inline bool subset_of(const packed_set& other) const {
+    size_t n = words_.size();
+    if (n > other.words_.size()) return false;
+    const uint64_t* x = words_.data();
+    const uint64_t* y = other.words_.data();
+    uint64_t diff = 0;
+    for (size_t i = 0; i < n; ++i)
+      diff |= x[i] & ~y[i];
+    return diff == 0;
+  }
+
+  inline bool operator==(const packed_set& other) const { return words_ == other.words_; }
+
+  inline bool empty() const { return words_.empty(); }
+};
+
+}
+}
+
+#endif // LIMI_INTERNAL_BITSET_H
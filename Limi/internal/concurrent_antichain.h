@@ -0,0 +1,139 @@
+/*
+ * Copyright 2016, IST Austria
+ *
+ * This file is part of Limi.
+ *
+ * Limi is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Limi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Limi.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIMI_INTERNAL_CONCURRENT_ANTICHAIN_H
+#define LIMI_INTERNAL_CONCURRENT_ANTICHAIN_H
+
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include "antichain.h"
+
+namespace Limi {
+namespace internal {
+
+/**
+ * @brief An antichain that can be used by several threads at once.
+ * 
+ * The elements of A are distributed over several shards by their hash. Every shard is an \ref antichain
+ * with its own lock. All pairs (a,b) with the same a are in the same shard, so every operation only
+ * locks one shard.
+ * 
+ * @tparam A The type of elements A
+ * @tparam B The type of elements B
+ */
+template <class A, class B, class HashA = std::hash<A>, class HashB = std::hash<B>, class CompareA = std::equal_to<A>, class CompareB = std::equal_to<B>>
+class concurrent_antichain
+{
+  typedef antichain<A, B, HashA, HashB, CompareA, CompareB> shard_antichain;
+  typedef internal::macrostate<B, HashB, CompareB> b_set;
+  typedef std::shared_ptr<const b_set> pb_set;
+  
+  struct shard {
+    std::mutex mutex;
+    shard_antichain elements;
+  };
+  std::vector<std::unique_ptr<shard>> shards;
+  
+  inline shard& get_shard(const A& a) {
+    size_t hash = HashA()(a);
+    return *shards[(hash ^ (hash >> 16)) % shards.size()];
+  }
+
+public:
+  /**
+   * @brief Creates an empty antichain
+   * 
+   * @param shard_count The number of shards (more shards mean less contention)
+   */
+  explicit concurrent_antichain(unsigned shard_count) {
+    if (shard_count == 0) shard_count = 1;
+    for (unsigned i = 0; i < shard_count; ++i)
+      shards.emplace_back(new shard());
+  }
+  
+  /**
+   * @brief Add to the antichain an element without checking if the invariant is preserved
+   */
+  void add_unchecked(const A& a, const pb_set& b, bool dirty = false) {
+    shard& s = get_shard(a);
+    std::lock_guard<std::mutex> lock(s.mutex);
+    s.elements.add_unchecked(a, b, dirty);
+  }
+  
+  /**
+   * @brief Adds (a,b) unless a smaller element is already contained in the antichain.
+   * 
+   * Testing and adding happen atomically, so if several threads try to add the same element only one of them succeeds.
+   * 
+   * @returns True if (a,b) was added
+   */
+  bool add_if_absent(const A& a, const pb_set& b, bool dirty = false) {
+    shard& s = get_shard(a);
+    std::lock_guard<std::mutex> lock(s.mutex);
+    return s.elements.try_add(a, b, dirty);
+  }
+  
+  /**
+   * @brief Tests if the element (a,b) or a smaller element is already contained in the antichain
+   */
+  bool contains(const A& a, const pb_set& b) {
+    shard& s = get_shard(a);
+    std::lock_guard<std::mutex> lock(s.mutex);
+    return s.elements.contains(a, b);
+  }
+  
+  /**
+   * @brief Returns the number of different elements of A in the antichain.
+   */
+  unsigned size() {
+    unsigned result = 0;
+    for (auto& s : shards) {
+      std::lock_guard<std::mutex> lock(s->mutex);
+      result += s->elements.size();
+    }
+    return result;
+  }
+  
+  /**
+   * @brief Remove elements marked as dirty
+   */
+  void clean_dirty() {
+    for (auto& s : shards) {
+      std::lock_guard<std::mutex> lock(s->mutex);
+      s->elements.clean_dirty();
+    }
+  }
+  
+  /**
+   * @brief Print the antichain on the screen (shard by shard).
+   */
+  void print(std::ostream& out, const printer_base<A>& printerA = printer<A>(), const printer_base<B>& printerB = printer<B>()) {
+    for (auto& s : shards) {
+      std::lock_guard<std::mutex> lock(s->mutex);
+      s->elements.print(out, printerA, printerB);
+    }
+  }
+};
+
+}
+}
+
+#endif // LIMI_INTERNAL_CONCURRENT_ANTICHAIN_H
@@ -0,0 +1,158 @@
+/*
+ * Copyright 2016, IST Austria
+ *
+ * This file is part of Limi.
+ *
+ * Limi is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Limi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Limi.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIMI_INTERNAL_FRONTIER_H
+#define LIMI_INTERNAL_FRONTIER_H
+
+#include <deque>
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+#include "../search_order.h"
+
+namespace Limi {
+namespace internal {
+
+/**
+ * @brief The pairs that the language inclusion algorithms still have to explore.
+ *
+ * Depending on the \ref search_order the frontier is a stack, a queue or a priority queue.
+ * For the priority orders the pair with the smallest priority is taken first, and of several pairs with the
+ * same priority the one pushed last (so the search stays depth-first among equals).
+ *
+ * @tparam Pair The type of the pairs
+ */
+template <class Pair>
+class frontier {
+public:
+  typedef std::function<unsigned(const Pair&)> priority_function;
+
+private:
+  struct prioritized {
+    unsigned priority;
+    unsigned long sequence;
+    Pair pair;
+    prioritized(unsigned priority, unsigned long sequence, Pair&& pair) : priority(priority), sequence(sequence), pair(std::move(pair)) {}
+  };
+
+  // true if x must be taken after y (std::push_heap keeps the largest element on top)
+  struct later {
+    inline bool operator()(const prioritized& x, const prioritized& y) const {
+      if (x.priority != y.priority) return x.priority > y.priority;
+      return x.sequence < y.sequence;
+    }
+  };
+
+  search_order order_ = search_order::depth_first;
+  priority_function priority_;
+  std::deque<Pair> pairs;
+  std::vector<prioritized> heap;
+  unsigned long sequence = 0;
+
+  inline bool prioritized_order() const {
+    return order_ == search_order::smallest_first || order_ == search_order::heuristic;
+  }
+
+public:
+  /**
+   * @brief Changes the order. The pairs already in the frontier are kept.
+   *
+   * @param order The new order
+   * @param priority The priority of a pair (smaller is explored first). Required for the priority orders.
+   */
+  void set_order(search_order order, const priority_function& priority = priority_function()) {
+    bool prioritized_now = order == search_order::smallest_first || order == search_order::heuristic;
+    if (prioritized_now && !priority)
+      throw std::logic_error("A priority function is needed for this search order");
+    std::vector<Pair> all;
+    while (!empty())
+      all.push_back(pop());
+    order_ = order;
+    priority_ = priority;
+    // pop returned the pairs in the order they would have been explored, keep it as far as the new order allows
+    if (order_ == search_order::depth_first) {
+      for (auto it = all.rbegin(); it != all.rend(); ++it)
+        push(std::move(*it));
+    } else {
+      for (Pair& p : all)
+        push_back(std::move(p));
+    }
+  }
+
+  /**
+   * @brief Returns the current order
+   */
+  inline search_order order() const {
+    return order_;
+  }
+
+  /**
+   * @brief Adds a newly found pair
+   */
+  void push(Pair&& p) {
+    if (prioritized_order()) {
+      unsigned priority = priority_(p);
+      heap.emplace_back(priority, sequence++, std::move(p));
+      std::push_heap(heap.begin(), heap.end(), later());
+    } else if (order_ == search_order::depth_first) {
+      pairs.push_front(std::move(p));
+    } else {
+      pairs.push_back(std::move(p));
+    }
+  }
+
+  /**
+   * @brief Adds a pair that is explored after the pairs already in the frontier (unless a priority says otherwise)
+   */
+  void push_back(Pair&& p) {
+    if (prioritized_order())
+      push(std::move(p));
+    else
+      pairs.push_back(std::move(p));
+  }
+
+  /**
+   * @brief Removes the next pair to explore and returns it. The frontier must not be empty.
+   */
+  Pair pop() {
+    if (!heap.empty()) {
+      std::pop_heap(heap.begin(), heap.end(), later());
+      Pair result = std::move(heap.back().pair);
+      heap.pop_back();
+      return result;
+    }
+    Pair result = std::move(pairs.front());
+    pairs.pop_front();
+    return result;
+  }
+
+  inline bool empty() const {
+    return pairs.empty() && heap.empty();
+  }
+
+  inline size_t size() const {
+    return pairs.size() + heap.size();
+  }
+};
+
+}
+}
+
+#endif // LIMI_INTERNAL_FRONTIER_H
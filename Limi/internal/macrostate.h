@@ -0,0 +1,294 @@
+/*
+ * Copyright 2016, IST Austria
+ *
+ * This file is part of Limi.
+ *
+ * Limi is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Limi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Limi.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIMI_INTERNAL_MACROSTATE_H
+#define LIMI_INTERNAL_MACROSTATE_H
+
+#include <unordered_set>
+#include <unordered_map>
+#include <memory>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include <mutex>
+#include "../generics.h"
+#include "bitset.h"
+
+namespace Limi {
+namespace internal {
+
+/**
+ * @brief The cardinality and a 64-bit signature of a set.
+ * 
+ * Each element sets one bit of the signature (Bloom filter with one hash function). If set1 ⊆ set2 then
+ * the signature of set1 is a subset of the signature of set2 and set1 is not larger than set2.
+ * Most subset tests in the antichain fail and this catches most of them without touching the sets.
+ * 
+ */
+template <class B, class HashB>
+struct set_summary {
+  size_t size = 0;
+  uint64_t signature = 0;
+  
+  template <class Set>
+  explicit set_summary(const Set& set) : size(set.size()) {
+    HashB hasher;
+    for (const B& b : set)
+      signature |= uint64_t(1) << ((static_cast<uint64_t>(hasher(b)) * 0x9e3779b97f4a7c15ull) >> 58);
+  }
+  
+  /**
+   * @brief Returns false if the set summarised by this cannot be a subset of the one summarised by other
+   */
+  inline bool may_be_subset(const set_summary& other) const {
+    return size <= other.size && (signature & ~other.signature) == 0;
+  }
+};
+
+/**
+ * @brief Precomputed data about a set of B that speeds up subset tests.
+ * 
+ * The general version only keeps the summary and subset tests probe the hash set once per element.
+ * 
+ */
+template <class B, class HashB, class CompareB, bool Dense = dense_index<B>::value>
+struct set_key : set_summary<B, HashB> {
+  typedef std::unordered_set<B, HashB, CompareB> b_set;
+  
+  explicit set_key(const b_set& set) : set_summary<B, HashB>(set) {}
+  
+  /**
+   * @brief Tests if set1 is a subset of set2
+   */
+  static inline bool contained(const b_set& set1, const set_key& key1, const b_set& set2, const set_key& key2) {
+    if (!key1.may_be_subset(key2))
+      return false;
+    for(auto it=set1.begin(); it!=set1.end(); it++) {
+      if (set2.find(*it) == set2.end())
+        return false;
+    }
+    return true;
+  }
+};
+
+/**
+ * @brief For dense states (see \ref Limi::dense_index) the set is stored as a packed bitset.
+ * 
+ * Subset tests then do not touch the hash set at all.
+ * 
+ */
+template <class B, class HashB, class CompareB>
+struct set_key<B, HashB, CompareB, true> : set_summary<B, HashB> {
+  typedef std::unordered_set<B, HashB, CompareB> b_set;
+  packed_set bits;
+  
+  explicit set_key(const b_set& set) : set_summary<B, HashB>(set), bits(set.begin(), set.end(), &dense_index<B>::index) {}
+  
+  /**
+   * @brief Tests if set1 is a subset of set2
+   */
+  static inline bool contained(const b_set&, const set_key& key1, const b_set&, const set_key& key2) {
+    return key1.may_be_subset(key2) && key1.bits.subset_of(key2.bits);
+  }
+};
+  
+/**
+ * @brief An immutable set of states of automaton B (a state of the determinised automaton).
+ * 
+ * Macrostates are created by a \ref macrostate_store, which makes sure that there is only one object
+ * for every set of states. Two macrostates from the same store are therefore equal iff they are the same object.
+ * The ids are only unique within one store; macrostates of different stores may share an id.
+ * The key used for subset tests is computed once when the macrostate is created.
+ * 
+ * @tparam B The type of states of automaton B
+ */
+template <class B, class HashB = std::hash<B>, class CompareB = std::equal_to<B>>
+class macrostate {
+public:
+  typedef std::unordered_set<B, HashB, CompareB> b_set;
+  typedef set_key<B, HashB, CompareB> b_key;
+  
+  macrostate(b_set&& states, size_t hash, unsigned id) : states_(std::move(states)), key_(states_), hash_(hash), id_(id) {}
+  
+  inline const b_set& states() const { return states_; }
+  inline const b_key& key() const { return key_; }
+  inline size_t size() const { return states_.size(); }
+  inline size_t hash() const { return hash_; }
+  inline unsigned id() const { return id_; }
+  
+  /**
+   * @brief Tests if this is a subset of other
+   * 
+   * The shortcut compares addresses and not ids, so macrostates of different stores can be compared.
+   */
+  inline bool subset_of(const macrostate& other) const {
+    return this == &other || b_key::contained(states_, key_, other.states_, other.key_);
+  }
+  
+private:
+  b_set states_;
+  b_key key_;
+  size_t hash_;
+  unsigned id_;
+};
+
+/**
+ * @brief Interns macrostates, so that every set of states is only stored once.
+ * 
+ * The store keeps all macrostates alive until it is destroyed.
+ * 
+ * The ids of the macrostates are offset, offset + stride, offset + 2*stride, ... so that several stores
+ * can hand out different ids (see \ref concurrent_macrostate_store).
+ * 
+ * @tparam B The type of states of automaton B
+ */
+template <class B, class HashB = std::hash<B>, class CompareB = std::equal_to<B>>
+class macrostate_store {
+public:
+  typedef macrostate<B, HashB, CompareB> state;
+  typedef std::shared_ptr<const state> pstate;
+  typedef typename state::b_set b_set;
+  
+  explicit macrostate_store(unsigned offset = 0, unsigned stride = 1) : offset(offset), stride(stride) {}
+  
+  /**
+   * @brief Returns the unique macrostate for a set of states.
+   * 
+   * @param states The set of states. It is moved into the new macrostate if there is none yet.
+   */
+  inline pstate intern(b_set&& states) {
+    size_t hash = hash_set(states);
+    return intern(std::move(states), hash);
+  }
+  
+  /**
+   * @brief Returns the unique macrostate for a set of states whose hash (see \ref hash_set()) is known.
+   */
+  pstate intern(b_set&& states, size_t hash) {
+    auto it = table.find(lookup{&states, hash});
+    if (it != table.end())
+      return it->second;
+    pstate result = std::make_shared<state>(std::move(states), hash, offset + table.size() * stride);
+    table.insert(std::make_pair(lookup{&result->states(), hash}, result));
+    return result;
+  }
+  
+  /**
+   * @brief Returns the unique macrostate for a set of states.
+   */
+  inline pstate intern(const b_set& states) {
+    return intern(b_set(states));
+  }
+  
+  /**
+   * @brief The number of different macrostates created so far.
+   */
+  inline unsigned size() const { return table.size(); }
+  
+  /**
+   * @brief The hash of a set of states (it does not depend on the order of the elements)
+   */
+  static size_t hash_set(const b_set& states) {
+    HashB hasher;
+    size_t seed = states.size();
+    for (const B& b : states)
+      seed += static_cast<size_t>((static_cast<uint64_t>(hasher(b)) + 0x9e3779b97f4a7c15ull) * 0xbf58476d1ce4e5b9ull);
+    return seed;
+  }
+  
+private:
+  unsigned offset;
+  unsigned stride;
+  
+  // the key points to the states of the macrostate that is stored as value (or to the query)
+  struct lookup {
+    const b_set* states;
+    size_t hash;
+  };
+  struct lookup_hash {
+    inline size_t operator()(const lookup& l) const { return l.hash; }
+  };
+  struct lookup_equal {
+    inline bool operator()(const lookup& l1, const lookup& l2) const { return l1.hash == l2.hash && *l1.states == *l2.states; }
+  };
+  std::unordered_map<lookup, pstate, lookup_hash, lookup_equal> table;
+};
+
+/**
+ * @brief A macrostate store that can be used by several threads at once.
+ * 
+ * The macrostates are distributed over several stores by their hash and every store has its own lock.
+ * Every store hands out different ids, so ids stay unique.
+ * 
+ * @tparam B The type of states of automaton B
+ */
+template <class B, class HashB = std::hash<B>, class CompareB = std::equal_to<B>>
+class concurrent_macrostate_store {
+  typedef macrostate_store<B, HashB, CompareB> store;
+public:
+  typedef typename store::state state;
+  typedef typename store::pstate pstate;
+  typedef typename store::b_set b_set;
+  
+  /**
+   * @brief Creates the store
+   * 
+   * @param shards The number of independent stores
+   */
+  explicit concurrent_macrostate_store(unsigned shards) {
+    if (shards == 0) shards = 1;
+    for (unsigned i = 0; i < shards; ++i)
+      shards_.emplace_back(new shard(i, shards));
+  }
+  
+  /**
+   * @brief Returns the unique macrostate for a set of states.
+   */
+  pstate intern(b_set&& states) {
+    size_t hash = store::hash_set(states);
+    shard& s = *shards_[(hash >> 7) % shards_.size()];
+    std::lock_guard<std::mutex> lock(s.mutex);
+    return s.macrostates.intern(std::move(states), hash);
+  }
+  
+  /**
+   * @brief The number of different macrostates created so far.
+   */
+  unsigned size() {
+    unsigned result = 0;
+    for (auto& s : shards_) {
+      std::lock_guard<std::mutex> lock(s->mutex);
+      result += s->macrostates.size();
+    }
+    return result;
+  }
+  
+private:
+  struct shard {
+    std::mutex mutex;
+    store macrostates;
+    shard(unsigned offset, unsigned stride) : macrostates(offset, stride) {}
+  };
+  std::vector<std::unique_ptr<shard>> shards_;
+};
+
+}
+}
+
+#endif // LIMI_INTERNAL_MACROSTATE_H
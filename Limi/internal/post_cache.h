@@ -0,0 +1,113 @@
+/*
+ * Copyright 2016, IST Austria
+ *
+ * This file is part of Limi.
+ *
+ * Limi is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Limi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Limi.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIMI_INTERNAL_POST_CACHE_H
+#define LIMI_INTERNAL_POST_CACHE_H
+
+#include <list>
+#include <unordered_map>
+#include <utility>
+#include <functional>
+#include "hash.h"
+
+namespace Limi {
+namespace internal {
+
+/**
+ * @brief The number of successors the language inclusion algorithms cache by default.
+ */
+const size_t default_post_cache_size = 1 << 18;
+
+/**
+ * @brief Remembers the successor macrostate of a macrostate for a symbol.
+ * 
+ * The key is the id of an interned macrostate and a symbol. The cache holds at most capacity
+ * entries and evicts the least recently used one when it is full. A capacity of 0 disables the cache.
+ * 
+ * @tparam Symbol The type of symbols
+ * @tparam Value The type of the cached successors (a pointer to a macrostate)
+ */
+template <class Symbol, class Value>
+class post_cache {
+  typedef std::pair<unsigned, Symbol> key;
+  typedef std::list<std::pair<key, Value>> lru_list;
+
+  lru_list entries; // most recently used first
+  std::unordered_map<key, typename lru_list::iterator> lookup;
+  size_t capacity_;
+  unsigned long hits_ = 0;
+  unsigned long misses_ = 0;
+public:
+  explicit post_cache(size_t capacity) : capacity_(capacity) {}
+
+  /**
+   * @brief Looks up the successor of macrostate id for symbol sigma.
+   * 
+   * @param result Is set to the cached successor if there is one.
+   * @return True if the successor was cached.
+   */
+  bool find(unsigned id, const Symbol& sigma, Value& result) {
+    if (capacity_ == 0) return false;
+    auto it = lookup.find(key(id, sigma));
+    if (it == lookup.end()) {
+      ++misses_;
+      return false;
+    }
+    ++hits_;
+    entries.splice(entries.begin(), entries, it->second);
+    result = it->second->second;
+    return true;
+  }
+
+  /**
+   * @brief Stores the successor of macrostate id for symbol sigma.
+   */
+  void insert(unsigned id, const Symbol& sigma, const Value& successor) {
+    if (capacity_ == 0) return;
+    key k(id, sigma);
+    if (lookup.find(k) != lookup.end()) return;
+    if (lookup.size() >= capacity_) {
+      lookup.erase(entries.back().first);
+      entries.pop_back();
+    }
+    entries.emplace_front(k, successor);
+    lookup.insert(std::make_pair(k, entries.begin()));
+  }
+
+  /**
+   * @brief Changes the maximal number of entries, evicting entries if needed.
+   */
+  void capacity(size_t capacity) {
+    capacity_ = capacity;
+    while (lookup.size() > capacity_) {
+      lookup.erase(entries.back().first);
+      entries.pop_back();
+    }
+  }
+
+  inline size_t capacity() const { return capacity_; }
+  inline size_t size() const { return lookup.size(); }
+  inline unsigned long hits() const { return hits_; }
+  inline unsigned long misses() const { return misses_; }
+};
+
+}
+}
+
+#endif // LIMI_INTERNAL_POST_CACHE_H
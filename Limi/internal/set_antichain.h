@@ -0,0 +1,292 @@
+/*
+ * Copyright 2016, IST Austria
+ *
+ * This file is part of Limi.
+ *
+ * Limi is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Limi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Limi.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIMI_INTERNAL_SET_ANTICHAIN_H
+#define LIMI_INTERNAL_SET_ANTICHAIN_H
+
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <memory>
+#include "macrostate.h"
+
+namespace Limi {
+namespace internal {
+
+/**
+ * @brief An antichain of interned sets with respect to inclusion, which keeps the minimal sets.
+ *
+ * The sets are stored in entries and referred to by their position there (the id of the entry).
+ * Removed entries stay in the vector (with set == nullptr) until more than half of the entries are removed,
+ * so ids stay valid in between.
+ *
+ * Besides, the ids of the live sets are grouped by cardinality. A subset of a query can be at most as
+ * large as the query and a strict superset must be strictly larger, so each search only looks at one
+ * side of the groups. The groups are unordered and an id is removed from its group by swapping it with the last one.
+ *
+ * Small antichains are scanned group by group. Once an antichain grows beyond index_threshold every set is
+ * filed under one of its elements (the watched element). A set can only be a subset of a query if its
+ * watched element is in the query, so \ref contains_subset() only tests the sets watched by elements of the query.
+ * The watched element is chosen so that the lists stay short.
+ *
+ * Because the sets are interned the antichain also knows the addresses of all its sets. A query for a set that
+ * is stored exactly is answered without any subset test. The ids of the macrostates are not used for this,
+ * because the sets may come from different stores whose ids overlap.
+ *
+ * This is the bucket of one element of A in \ref antichain and the whole antichain of \ref universality_algo.
+ *
+ * @tparam B The type of the elements of the sets
+ */
+template <class B, class HashB = std::hash<B>, class CompareB = std::equal_to<B>>
+class set_antichain
+{
+public:
+  typedef internal::macrostate<B, HashB, CompareB> set_type;
+  typedef std::shared_ptr<const set_type> pset;
+
+private:
+  // antichains with at least this many sets get an inverted index
+  static const unsigned index_threshold = 32;
+
+  struct entry {
+    pset set; // nullptr if the entry was removed
+    unsigned pos; // position in the cardinality list of the set
+    entry(const pset& set, unsigned pos) : set(set), pos(pos) {}
+  };
+
+  std::vector<entry> entries;
+  std::vector<std::vector<unsigned>> by_size; // ids of the live entries for each cardinality
+  std::unordered_map<const set_type*, unsigned> ids; // the ids of the live sets by address
+  std::unordered_map<B, std::vector<unsigned>, HashB, CompareB> watches;
+  std::vector<unsigned> unwatched; // empty sets have no element to watch
+  bool indexed = false;
+  unsigned removed = 0;
+
+  void watch(unsigned id) {
+    std::vector<unsigned>* shortest = nullptr;
+    for (const B& b : entries[id].set->states()) {
+      std::vector<unsigned>& list = watches[b];
+      if (!shortest || list.size() < shortest->size()) {
+        shortest = &list;
+        if (list.empty()) break;
+      }
+    }
+    if (shortest)
+      shortest->push_back(id);
+    else
+      unwatched.push_back(id);
+  }
+
+  void remove(unsigned id) {
+    entry& e = entries[id];
+    std::vector<unsigned>& group = by_size[e.set->size()];
+    unsigned last = group.back();
+    group[e.pos] = last;
+    entries[last].pos = e.pos;
+    group.pop_back();
+    ids.erase(e.set.get());
+    e.set = nullptr;
+    ++removed;
+  }
+
+  /**
+   * @brief Drops removed entries and rebuilds the groups and the index
+   */
+  void rebuild() {
+    if (removed > 0) {
+      entries.erase(std::remove_if(entries.begin(), entries.end(), [](const entry& el) { return !el.set; }), entries.end());
+      removed = 0;
+      for (std::vector<unsigned>& group : by_size)
+        group.clear();
+      for (unsigned id = 0; id < entries.size(); ++id) {
+        std::vector<unsigned>& group = by_size[entries[id].set->size()];
+        entries[id].pos = group.size();
+        group.push_back(id);
+        ids[entries[id].set.get()] = id;
+      }
+    }
+    watches.clear();
+    unwatched.clear();
+    indexed = entries.size() >= index_threshold;
+    if (indexed) {
+      for (unsigned id = 0; id < entries.size(); ++id)
+        watch(id);
+    }
+  }
+
+  inline void maybe_compact() {
+    if (removed * 2 > entries.size())
+      rebuild();
+  }
+
+public:
+  /**
+   * @brief Adds a set without checking if the invariant is preserved
+   *
+   * @returns False if the set itself is already in the antichain
+   */
+  bool insert(const pset& set) {
+    unsigned id = entries.size();
+    if (!ids.insert(std::make_pair(set.get(), id)).second)
+      return false;
+    size_t size = set->size();
+    if (size >= by_size.size())
+      by_size.resize(size + 1);
+    entries.emplace_back(set, by_size[size].size());
+    by_size[size].push_back(id);
+    if (indexed)
+      watch(id);
+    else if (entries.size() >= index_threshold)
+      rebuild();
+    return true;
+  }
+
+  /**
+   * @brief Adds a set unless the antichain contains a subset of it, and removes the supersets of it.
+   *
+   * The subsets and the strict supersets are searched in one pass over the groups (the groups up to the size of
+   * the set and the ones above).
+   *
+   * @param set The set to add
+   * @param on_remove Called with every set that is removed
+   * @returns True if the set was added
+   */
+  template <class F>
+  bool try_insert(const pset& set, F on_remove) {
+    // the smallest subset should stay in
+    if (contains_subset(*set))
+      return false;
+    // a strict superset is strictly larger; equal sets were found above
+    for (size_t size = set->size() + 1; size < by_size.size(); ++size) {
+      std::vector<unsigned>& group = by_size[size];
+      for (unsigned i = 0; i < group.size();) {
+        if (set->subset_of(*entries[group[i]].set)) {
+          on_remove(entries[group[i]].set.get());
+          remove(group[i]); // moves the last id of the group to i
+        } else {
+          ++i;
+        }
+      }
+    }
+    maybe_compact();
+    insert(set);
+    return true;
+  }
+
+  inline bool try_insert(const pset& set) {
+    return try_insert(set, [](const set_type*) {});
+  }
+
+  /**
+   * @brief Tests if the antichain contains a subset of set
+   */
+  bool contains_subset(const set_type& set) const {
+    if (ids.find(&set) != ids.end())
+      return true;
+    if (indexed) {
+      for (unsigned id : unwatched) {
+        if (entries[id].set) return true;
+      }
+      for (const B& x : set.states()) {
+        auto list = watches.find(x);
+        if (list == watches.end()) continue;
+        for (unsigned id : list->second) {
+          const entry& e = entries[id];
+          if (e.set && e.set->subset_of(set))
+            return true;
+        }
+      }
+      return false;
+    }
+    size_t max_size = std::min(set.size() + 1, by_size.size());
+    for (size_t size = 0; size < max_size; ++size) {
+      for (unsigned id : by_size[size]) {
+        if (entries[id].set->subset_of(set))
+          return true;
+      }
+    }
+    return false;
+  }
+
+  /**
+   * @brief Tests if the set itself is stored (it was added and not removed since)
+   */
+  inline bool stored(const set_type& set) const {
+    return ids.find(&set) != ids.end();
+  }
+
+  /**
+   * @brief Tests if pred holds for any set of the antichain
+   */
+  template <class F>
+  bool any_of(F pred) const {
+    for (const entry& e : entries) {
+      if (e.set && pred(*e.set))
+        return true;
+    }
+    return false;
+  }
+
+  /**
+   * @brief Removes the sets for which pred holds and calls on_remove with each of them
+   */
+  template <class F, class G>
+  void remove_if(F pred, G on_remove) {
+    for (unsigned id = 0; id < entries.size(); ++id) {
+      const entry& e = entries[id];
+      if (e.set && pred(*e.set)) {
+        on_remove(e.set.get());
+        remove(id);
+      }
+    }
+    maybe_compact();
+  }
+
+  /**
+   * @brief Removes the set if it is in the antichain
+   */
+  void erase(const set_type* set) {
+    auto it = ids.find(set);
+    if (it == ids.end()) return;
+    remove(it->second);
+    maybe_compact();
+  }
+
+  /**
+   * @brief Returns the number of sets in the antichain
+   */
+  inline size_t size() const {
+    return ids.size();
+  }
+
+  /**
+   * @brief Calls f with every set of the antichain
+   */
+  template <class F>
+  void for_each(F f) const {
+    for (const entry& e : entries) {
+      if (e.set) f(e.set);
+    }
+  }
+};
+
+}
+}
+
+#endif // LIMI_INTERNAL_SET_ANTICHAIN_H
@@ -0,0 +1,364 @@
+/*
+ * Copyright 2016, IST Austria
+ *
+ * This file is part of Limi.
+ *
+ * Limi is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Limi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Limi.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIMI_INTERNAL_SIMULATION_REFINEMENT_H
+#define LIMI_INTERNAL_SIMULATION_REFINEMENT_H
+
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+#include "../explicit_automaton.h"
+
+namespace Limi {
+namespace internal {
+
+/**
+ * @brief Returns the index of the lowest bit set in word (word must not be 0)
+ */
+inline unsigned lowest_bit(uint64_t word) {
+#if defined(__GNUC__) || defined(__clang__)
+  return __builtin_ctzll(word);
+#else
+  unsigned i = 0;
+  while (!(word & 1)) {
+    word >>= 1;
+    ++i;
+  }
+  return i;
+#endif
+}
+
+/**
+ * @brief A preorder on the states of an automaton, stored as a partition of the states and a relation on the blocks.
+ *
+ * All states of a block are related to the same blocks, so the relation needs one row of bits per block.
+ * Bit D of row C is set iff every state of block D is above every state of block C.
+ */
+class partition_relation {
+  std::vector<unsigned> block_;                  // the block of each state
+  std::vector<unsigned> position_;               // the position of each state in the members of its block
+  std::vector<std::vector<unsigned>> members_;   // the states of each block
+  std::vector<std::vector<uint64_t>> relation_;  // one row per block
+  size_t words_ = 1; // words per row
+
+public:
+  enum : unsigned { none = static_cast<unsigned>(-1) };
+
+  /**
+   * @brief Creates a relation on n states that are not in any block yet
+   */
+  explicit partition_relation(size_t n = 0) : block_(n, static_cast<unsigned>(none)), position_(n, 0) {}
+
+  inline size_t size() const { return block_.size(); }
+  inline size_t block_count() const { return members_.size(); }
+
+  inline unsigned block(size_t q) const { return block_[q]; }
+  inline const std::vector<unsigned>& members(unsigned b) const { return members_[b]; }
+
+  inline bool related(unsigned c, unsigned d) const { return (relation_[c][d >> 6] >> (d & 63)) & 1; }
+  inline void relate(unsigned c, unsigned d) { relation_[c][d >> 6] |= uint64_t(1) << (d & 63); }
+  inline void unrelate(unsigned c, unsigned d) { relation_[c][d >> 6] &= ~(uint64_t(1) << (d & 63)); }
+
+  /**
+   * @brief Tests if r is above q
+   */
+  inline bool get(size_t q, size_t r) const { return related(block_[q], block_[r]); }
+
+  /**
+   * @brief Adds an empty block that is not related to any block
+   */
+  unsigned add_block() {
+    if (members_.size() == words_ * 64) {
+      words_ *= 2;
+      for (auto& row : relation_)
+        row.resize(words_, 0);
+    }
+    members_.emplace_back();
+    relation_.emplace_back(words_, 0);
+    return members_.size() - 1;
+  }
+
+  /**
+   * @brief Moves state q to block b
+   */
+  void move(unsigned q, unsigned b) {
+    if (block_[q] != none) {
+      std::vector<unsigned>& old = members_[block_[q]];
+      position_[old.back()] = position_[q];
+      old[position_[q]] = old.back();
+      old.pop_back();
+    }
+    block_[q] = b;
+    position_[q] = members_[b].size();
+    members_[b].push_back(q);
+  }
+
+  /**
+   * @brief Calls f(d) for every block d above block c
+   */
+  template <class F>
+  void for_each_block(unsigned c, F f) const {
+    const std::vector<uint64_t>& row = relation_[c];
+    for (size_t w = 0; w < words_; ++w) {
+      uint64_t word = row[w];
+      while (word) {
+        f(unsigned(w * 64 + lowest_bit(word)));
+        word &= word - 1;
+      }
+    }
+  }
+
+  /**
+   * @brief Calls f(r) for every state r above state q (including q)
+   */
+  template <class F>
+  void for_each(size_t q, F f) const {
+    for_each_block(block_[q], [&](unsigned d) {
+      for (unsigned r : members_[d])
+        f(size_t(r));
+    });
+  }
+
+  /**
+   * @brief Makes block d a copy of block c: d is related to the blocks above c and is above the blocks below c
+   */
+  void copy_block(unsigned c, unsigned d) {
+    relation_[d] = relation_[c];
+    for (auto& row : relation_) {
+      if ((row[c >> 6] >> (c & 63)) & 1)
+        row[d >> 6] |= uint64_t(1) << (d & 63);
+    }
+  }
+};
+
+/**
+ * @brief Computes the maximal simulation preorder of an explicit automaton.
+ *
+ * This is the partition-relation refinement of Ranzato and Tapparo in the version for labelled transition systems
+ * (Abdulla et al., "Computing simulations over tree automata"). The relation is kept as a \ref partition_relation.
+ * It starts with the blocks of states that agree on acceptance and on the available symbols, where block D is above C iff
+ * D is accepting if C is and has all symbols of C. For every block B and symbol a the set Remove_a(B) holds the states
+ * that have an a-successor but none in a block above B, so they cannot simulate an a-predecessor of B.
+ * Processing a nonempty Remove_a(B) splits the blocks such that Remove is a union of blocks, and then unrelates these
+ * blocks from the blocks of the a-predecessors of B. A state v whose b-successors are no longer above a block C
+ * after this is added to Remove_b(C). When a block is split both parts keep the relation and the remove sets of the old block.
+ *
+ * Nothing is stored per pair of states. Whether v still has a b-successor above C is tested on its b-transitions,
+ * which only happens once for every block C, state v and transition from v into a block that is unrelated from C.
+ *
+ * For the forward simulation the accepting states are the final states and the transitions are followed forwards.
+ * For the backward simulation the accepting states are the initial states and the transitions are reversed.
+ * Epsilon transitions are treated like any other symbol.
+ *
+ * @param aut The automaton
+ * @param backward Compute the backward instead of the forward simulation
+ * @return The relation where r is above q iff r simulates q.
+ */
+template <class State, class Symbol>
+partition_relation refine_simulation(const explicit_automaton<State, Symbol>& aut, bool backward) {
+  using automaton_type = explicit_automaton<State, Symbol>;
+  using transition_vector = typename automaton_type::transition_vector;
+  const size_t n = aut.size();
+  auto forward = [&](unsigned q) -> const transition_vector& { return backward ? aut.reverse_transitions(q) : aut.transitions(q); };
+  auto reverse = [&](unsigned q) -> const transition_vector& { return backward ? aut.transitions(q) : aut.reverse_transitions(q); };
+  auto accepting = [&](unsigned q) { return backward ? aut.is_initial(q) : aut.is_final_state(q); };
+
+  // the initial blocks: states with the same acceptance and the same symbols (the last word is the acceptance)
+  const size_t sym_words = (aut.symbol_count() + 63) / 64 + 1;
+  partition_relation rel(n);
+  std::vector<std::vector<uint64_t>> signatures;
+  {
+    std::map<std::vector<uint64_t>, unsigned> blocks;
+    std::vector<uint64_t> signature(sym_words);
+    for (unsigned q = 0; q < n; ++q) {
+      std::fill(signature.begin(), signature.end(), 0);
+      for (const auto& t : forward(q))
+        signature[t.symbol >> 6] |= uint64_t(1) << (t.symbol & 63);
+      signature.back() = accepting(q) ? 1 : 0;
+      auto it = blocks.insert(std::make_pair(signature, unsigned(rel.block_count())));
+      if (it.second) {
+        rel.add_block();
+        signatures.push_back(signature);
+      }
+      rel.move(q, it.first->second);
+    }
+  }
+  for (unsigned c = 0; c < rel.block_count(); ++c) {
+    for (unsigned d = 0; d < rel.block_count(); ++d) {
+      uint64_t diff = 0;
+      for (size_t w = 0; w < sym_words; ++w)
+        diff |= signatures[c][w] & ~signatures[d][w];
+      if (diff == 0)
+        rel.relate(c, d);
+    }
+  }
+
+  // the runs of transitions with the same source and symbol, and for every state the runs that lead to it
+  struct run {
+    unsigned state;
+    unsigned symbol;
+    unsigned begin;
+    unsigned end;
+  };
+  std::vector<run> runs;
+  std::vector<std::vector<unsigned>> runs_into(n);
+  for (unsigned v = 0; v < n; ++v) {
+    const transition_vector& succ = forward(v);
+    for (unsigned i = 0; i < succ.size();) {
+      unsigned end = i;
+      while (end < succ.size() && succ[end].symbol == succ[i].symbol) {
+        runs_into[succ[end].target].push_back(runs.size());
+        ++end;
+      }
+      runs.push_back(run{v, succ[i].symbol, i, end});
+      i = end;
+    }
+  }
+
+  // tests if the source of the run has a successor in the run in a block above c
+  auto has_successor = [&](const run& r, unsigned c) {
+    const transition_vector& succ = forward(r.state);
+    for (unsigned i = r.begin; i < r.end; ++i) {
+      if (rel.related(c, rel.block(succ[i].target)))
+        return true;
+    }
+    return false;
+  };
+
+  // the nonempty remove sets by (block, symbol)
+  std::map<std::pair<unsigned, unsigned>, std::vector<unsigned>> remove;
+  for (unsigned b = 0; b < rel.block_count(); ++b) {
+    for (const run& r : runs) {
+      if (!has_successor(r, b))
+        remove[std::make_pair(b, r.symbol)].push_back(r.state);
+    }
+  }
+
+  const unsigned none = static_cast<unsigned>(partition_relation::none);
+  std::vector<unsigned> stamp(n, 0);
+  unsigned time = 0;
+  std::vector<unsigned> removed_states, predecessors, hits, split_to, touched, removed_blocks, pred_blocks, unrelated;
+  std::vector<unsigned> run_stamp(runs.size(), 0);
+  while (!remove.empty()) {
+    auto first = remove.begin();
+    const unsigned b = first->first.first;
+    const unsigned symbol = first->first.second;
+    removed_states.swap(first->second);
+    remove.erase(first);
+
+    // the a-predecessors of B before B is split
+    ++time;
+    predecessors.clear();
+    for (unsigned q : rel.members(b)) {
+      auto range = automaton_type::symbol_range(reverse(q), symbol);
+      for (auto t = range.first; t != range.second; ++t) {
+        if (stamp[t->target] != time) {
+          stamp[t->target] = time;
+          predecessors.push_back(t->target);
+        }
+      }
+    }
+
+    // a state can be added to a remove set twice
+    ++time;
+    size_t kept = 0;
+    for (unsigned v : removed_states) {
+      if (stamp[v] != time) {
+        stamp[v] = time;
+        removed_states[kept++] = v;
+      }
+    }
+    removed_states.resize(kept);
+
+    // split the blocks such that Remove is a union of blocks
+    hits.resize(rel.block_count(), 0);
+    touched.clear();
+    for (unsigned v : removed_states) {
+      if (hits[rel.block(v)]++ == 0)
+        touched.push_back(rel.block(v));
+    }
+    split_to.resize(rel.block_count(), none);
+    for (unsigned c : touched) {
+      const bool whole = hits[c] == rel.members(c).size();
+      hits[c] = 0;
+      if (whole) continue;
+      const unsigned d = rel.add_block();
+      split_to[c] = d;
+      rel.copy_block(c, d);
+      for (auto it = remove.lower_bound(std::make_pair(c, 0u)); it != remove.end() && it->first.first == c; ++it)
+        remove.insert(std::make_pair(std::make_pair(d, it->first.second), it->second));
+    }
+    removed_blocks.clear();
+    for (unsigned v : removed_states) {
+      const unsigned c = rel.block(v);
+      if (split_to[c] != none)
+        rel.move(v, split_to[c]);
+    }
+    for (unsigned c : touched)
+      split_to[c] = none;
+    ++time;
+    for (unsigned v : removed_states) {
+      if (stamp[v] != time) {
+        for (unsigned q : rel.members(rel.block(v)))
+          stamp[q] = time;
+        removed_blocks.push_back(rel.block(v));
+      }
+    }
+    ++time;
+    pred_blocks.clear();
+    for (unsigned p : predecessors) {
+      if (stamp[p] != time) {
+        for (unsigned q : rel.members(rel.block(p)))
+          stamp[q] = time;
+        pred_blocks.push_back(rel.block(p));
+      }
+    }
+
+    // no state of Remove simulates an a-predecessor of B
+    for (unsigned c : pred_blocks) {
+      unrelated.clear();
+      for (unsigned d : removed_blocks) {
+        if (rel.related(c, d)) {
+          rel.unrelate(c, d);
+          unrelated.push_back(d);
+        }
+      }
+      if (unrelated.empty()) continue;
+      ++time;
+      for (unsigned d : unrelated) {
+        for (unsigned q : rel.members(d)) {
+          for (unsigned i : runs_into[q]) {
+            if (run_stamp[i] == time) continue;
+            run_stamp[i] = time;
+            if (!has_successor(runs[i], c))
+              remove[std::make_pair(c, runs[i].symbol)].push_back(runs[i].state);
+          }
+        }
+      }
+    }
+  }
+  return rel;
+}
+
+}
+}
+
+#endif // LIMI_INTERNAL_SIMULATION_REFINEMENT_H
@@ -0,0 +1,296 @@
+/*
+ * Copyright 2016, IST Austria
+ *
+ * This file is part of Limi.
+ *
+ * Limi is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Limi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Limi.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIMI_PARALLEL_ANTICHAINALGO_H
+#define LIMI_PARALLEL_ANTICHAINALGO_H
+
+#include "automaton.h"
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <iostream>
+#include "internal/concurrent_antichain.h"
+#include "internal/macrostate.h"
+#include "internal/post_cache.h"
+#include "results.h"
+#include "internal/helpers.h"
+
+namespace Limi {
+
+/**
+  * @brief The antichain algorithm of \ref antichain_algo run by several threads.
+  * 
+  * Every thread has its own deque of pairs. A thread takes the pair it pushed last (so every thread
+  * explores depth-first like \ref antichain_algo) and if its deque is empty it steals the oldest pair of
+  * another thread. The antichain and the macrostates are shared (see \ref internal::concurrent_antichain),
+  * every thread has its own cache of successor macrostates. As soon as one thread finds a counter-example
+  * all threads stop.
+  * 
+  * The result is the same as the one of \ref antichain_algo, but if language inclusion does not hold
+  * the counter-example may be a different one. Run can be called again to produce another counter-example.
+  * 
+  * The automata are queried from several threads at the same time, so their const methods must not modify
+  * shared state.
+  * 
+  * @tparam ImplementationA The implementation class of Automaton A
+  * @tparam ImplementationB The implementation class of Automaton B
+  * 
+  */
+template <class ImplementationA, class ImplementationB>
+class parallel_antichain_algo
+{
+  using StateA = typename ImplementationA::State_;
+  using Symbol = typename ImplementationA::Symbol_;
+  using StateB = typename ImplementationB::State_;
+  
+  using StateA_vector = std::vector<StateA>;
+  using StateB_set = std::unordered_set<StateB>;
+  using StateB_store = internal::concurrent_macrostate_store<StateB>;
+  using StateBI_set = typename StateB_store::pstate;
+  using Symbol_vector = std::vector<Symbol>;
+  using AutomatonA = automaton<StateA, Symbol, ImplementationA>;
+  using AutomatonB = automaton<StateB, Symbol, ImplementationB>;
+  
+  using counter_chain = counterexample_chain<Symbol>;
+  using pcounter_chain = std::shared_ptr<counter_chain>;
+  
+  struct pair {
+    StateA a;
+    StateBI_set b;
+    pair(StateA a, StateBI_set b) : a(a), b(b), cex_chain(nullptr) {}
+    pair(StateA a, StateBI_set b, const pcounter_chain& parent, const Symbol& sym) : pair(a,b)
+    {
+      cex_chain = std::make_shared<counter_chain>(sym, parent);
+    }
+    pcounter_chain cex_chain;
+  };
+  
+  using pair_antichain = internal::concurrent_antichain<StateA, StateB>;
+  
+  struct worker {
+    std::mutex mutex;
+    std::deque<pair> pairs; // the owner works at the back, thieves at the front
+    internal::post_cache<Symbol, StateBI_set> posts;
+    explicit worker(size_t post_cache_size) : posts(post_cache_size) {}
+  };
+  
+  const AutomatonA& a;
+  const AutomatonB& b;
+  unsigned threads;
+  StateB_store macrostates;
+  pair_antichain antichain;
+  std::vector<std::unique_ptr<worker>> workers;
+  
+  std::atomic<unsigned long> pending; // pairs that are in a deque or being processed
+  std::atomic<unsigned long> pushes; // counts the pushed pairs, so idle workers notice new work
+  std::atomic<unsigned> idle_workers;
+  std::mutex idle_mutex;
+  std::condition_variable idle;
+  std::atomic<bool> found;
+  std::mutex result_mutex;
+  inclusion_result<Symbol> result;
+  
+  void push(unsigned id, pair&& p) {
+    worker& w = *workers[id];
+    ++pending;
+    {
+      std::lock_guard<std::mutex> lock(w.mutex);
+      w.pairs.push_back(std::move(p));
+    }
+    ++pushes;
+    if (idle_workers > 0) {
+      std::lock_guard<std::mutex> lock(idle_mutex);
+      idle.notify_one();
+    }
+  }
+  
+  /**
+   * @brief Wakes all idle workers, when the search is finished or a counter-example was found
+   */
+  void wake_all() {
+    std::lock_guard<std::mutex> lock(idle_mutex);
+    idle.notify_all();
+  }
+  
+  /**
+   * @brief Takes a pair from the own deque or steals one and processes it
+   * 
+   * @return False if all deques were empty
+   */
+  bool step(unsigned id) {
+    {
+      worker& w = *workers[id];
+      std::unique_lock<std::mutex> lock(w.mutex);
+      if (!w.pairs.empty()) {
+        pair current = std::move(w.pairs.back());
+        w.pairs.pop_back();
+        lock.unlock();
+        process(id, current);
+        return true;
+      }
+    }
+    for (unsigned i = 1; i < threads; ++i) {
+      worker& victim = *workers[(id + i) % threads];
+      std::unique_lock<std::mutex> lock(victim.mutex);
+      if (!victim.pairs.empty()) {
+        pair current = std::move(victim.pairs.front());
+        victim.pairs.pop_front();
+        lock.unlock();
+        process(id, current);
+        return true;
+      }
+    }
+    return false;
+  }
+  
+  /**
+   * @brief Returns the successor macrostate of states for sigma (cached per thread)
+   */
+  StateBI_set post(worker& w, const StateBI_set& states, const Symbol& sigma) {
+    StateBI_set result;
+    if (w.posts.find(states->id(), sigma, result))
+      return result;
+    StateB_set successors;
+    b.successors(states->states(), sigma, successors);
+    result = macrostates.intern(std::move(successors));
+    w.posts.insert(states->id(), sigma, result);
+    return result;
+  }
+  
+  void process(unsigned id, const pair& current) {
+    if (a.is_final_state(current.a) && !b.is_final_state(current.b->states())) {
+      std::lock_guard<std::mutex> lock(result_mutex);
+      if (!found) {
+        found = true;
+        result.included = false;
+        if (current.cex_chain)
+          result.counter_example = current.cex_chain->to_vector();
+      }
+      return;
+    }
+    worker& w = *workers[id];
+    Symbol_vector next_symbols;
+    a.next_symbols(current.a, next_symbols);
+    for (const Symbol& sigma : next_symbols) {
+      StateA_vector states_a = a.successors(current.a, sigma);
+      StateBI_set states_b = a.is_epsilon(sigma) ? current.b : post(w, current.b, sigma);
+      for (const StateA& state_a : states_a) {
+        if (antichain.add_if_absent(state_a, states_b, false))
+          push(id, pair(state_a, states_b, current.cex_chain, sigma));
+      }
+    }
+  }
+  
+  void work(unsigned id) {
+    while (!found) {
+      unsigned long seen = pushes;
+      if (step(id)) {
+        if (--pending == 0 || found)
+          wake_all();
+        continue;
+      }
+      if (pending == 0) break;
+      // idle until a pair is pushed (it may have been pushed after step() looked), the search is finished or a counter-example found
+      std::unique_lock<std::mutex> lock(idle_mutex);
+      ++idle_workers;
+      idle.wait(lock, [&] { return found || pending == 0 || pushes != seen; });
+      --idle_workers;
+    }
+  }
+  
+  void initial_states() {
+    StateB_set initial_b;
+    b.initial_states(initial_b);
+    StateBI_set states_b = macrostates.intern(std::move(initial_b));
+    for(StateA state_a : a.initial_states()) {
+      antichain.add_unchecked(state_a, states_b, false);
+      push(0, pair(state_a, states_b));
+    }
+  }
+
+public:
+
+  /**
+    * @brief Constructor that initialises the language inclusion algorithm.
+    * 
+    * @param a The automaton a
+    * @param b The automaton b. The b automaton must not produce any epsilon transitions.
+    * @param threads The number of threads (0 uses one thread per core)
+    * @param post_cache_size The maximal number of successor macrostates of b that are cached by each thread (0 disables the cache)
+    * 
+    */
+  parallel_antichain_algo(const AutomatonA& a, const AutomatonB& b, unsigned threads = 0, size_t post_cache_size = internal::default_post_cache_size) :
+    a(a), b(b), threads(threads ? threads : std::max(1u, std::thread::hardware_concurrency())),
+    macrostates(this->threads * 4), antichain(this->threads * 16), pending(0), pushes(0), idle_workers(0), found(false) {
+      if (!b.collapse_epsilon && !b.no_epsilon_produced) {
+        throw std::logic_error("For the automaton B in the language inclusion algorithm either collapse_epsilon must be true or no_epsilon_produced");
+      }
+      for (unsigned i = 0; i < this->threads; ++i)
+        workers.emplace_back(new worker(post_cache_size));
+      initial_states();
+    }
+  
+  /**
+    * @brief Returns the number of threads.
+    */
+  inline unsigned get_threads() const {
+    return threads;
+  }
+  
+  /**
+    * @brief Run the language inclusion.
+    * 
+    * Can be called several time to obtain several counter-examples.
+    * 
+    * @return Language inclusion result and a counter-example trace (if applicable)
+    */
+  inclusion_result<Symbol> run()
+  {
+    result = inclusion_result<Symbol>();
+    result.included = true;
+    result.bound_hit = false;
+    found = false;
+    
+    std::vector<std::thread> pool;
+    for (unsigned i = 1; i < threads; ++i)
+      pool.emplace_back(&parallel_antichain_algo::work, this, i);
+    work(0);
+    for (std::thread& t : pool)
+      t.join();
+
+#ifdef DEBUG_PRINTING
+    if (DEBUG_PRINTING>=1) std::cout << "threads: " << threads << "; seen states: " << antichain.size() << "; macrostates: " << macrostates.size() << std::endl;
+    
+    if (DEBUG_PRINTING >= 4) {
+      antichain.print(std::cout, a.state_printer(), b.state_printer());
+    }
+#endif
+
+    return result;
+  }
+  
+};
+
+}
+
+#endif // LIMI_PARALLEL_ANTICHAINALGO_H
@@ -0,0 +1,377 @@
+/*
+ * Copyright 2016, IST Austria
+ *
+ * This file is part of Limi.
+ *
+ * Limi is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Limi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Limi.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIMI_PARALLEL_ANTICHAINALGO_IND_H
+#define LIMI_PARALLEL_ANTICHAINALGO_IND_H
+
+#include "automaton.h"
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <iostream>
+#include <stdexcept>
+#include "internal/concurrent_antichain.h"
+#include "internal/macrostate.h"
+#include "internal/post_cache.h"
+#include "results.h"
+#include "internal/helpers.h"
+#include "internal/meta_automaton.h"
+
+namespace Limi {
+
+/**
+  * @brief The antichain algorithm modulo independence of \ref antichain_algo_ind run by several threads.
+  * 
+  * The threads share the work like in \ref parallel_antichain_algo: every thread has its own deque of pairs
+  * and steals from the others if it runs out of work. The antichain and the macrostates are shared.
+  * 
+  * Every thread keeps its own list of the pairs that were pruned because of the bound (before_dirty), so pruning
+  * needs no synchronisation. When increase_bound() is called (between two runs) the lists are merged and their
+  * pairs are spread over the deques of all threads. Dirty pairs are stamped with the generation of the bound
+  * they were created in and dropped when they are taken after the bound was increased, like in \ref antichain_algo_ind.
+  * 
+  * The results are the same as the ones of \ref antichain_algo_ind up to the choice of the counter-example.
+  * The automaton B and the independence relation are queried from several threads at the same time, so their
+  * const methods must not modify shared state.
+  * 
+  * @tparam ImplementationA The implementation class of Automaton A
+  * @tparam InnerImplementationB The implementation class of Automaton B
+  * @tparam Independence The independence relation (defaults to \ref Limi::independence).
+  * 
+  */
+template <class ImplementationA, class InnerImplementationB, class Independence = independence<typename ImplementationA::Symbol_>>
+class parallel_antichain_algo_ind
+{
+  using StateA = typename ImplementationA::State_;
+  using InnerStateB = typename InnerImplementationB::State_;
+  using Symbol = typename ImplementationA::Symbol_;
+  
+  using ImplementationB = internal::meta_automaton<InnerImplementationB, Independence>;
+  using StateB = typename ImplementationB::StateI;
+  using StateA_vector = std::vector<StateA>;
+  using StateB_set = std::unordered_set<StateB>;
+  using StateB_store = internal::concurrent_macrostate_store<StateB>;
+  using StateBI_set = typename StateB_store::pstate;
+  using Symbol_vector = std::vector<Symbol>;
+  using AutomatonA = automaton<StateA, Symbol, ImplementationA>;
+  using InnerAutomatonB = automaton<InnerStateB, Symbol, InnerImplementationB>;
+  using AutomatonB = automaton<StateB, Symbol, ImplementationB>;
+  
+  using counter_chain = counterexample_chain<Symbol>;
+  using pcounter_chain = std::shared_ptr<counter_chain>;
+  
+  struct pair {
+    StateA a;
+    StateBI_set b;
+    pair(StateA a, StateBI_set b) : a(a), b(b), cex_chain(nullptr) {}
+    pair(StateA a, StateBI_set b, const pcounter_chain& parent, const Symbol& sym) : pair(a,b)
+    {
+      cex_chain = std::make_shared<counter_chain>(sym, parent);
+    }
+    
+    bool dirty = false;
+    unsigned generation = 0; // a dirty pair is only valid in the generation it was created in
+    pcounter_chain cex_chain;
+  };
+  
+  using pair_antichain = internal::concurrent_antichain<StateA, StateB>;
+  
+  struct worker {
+    std::mutex mutex;
+    std::deque<pair> pairs; // the owner works at the back, thieves at the front
+    std::vector<pair> before_dirty; // only used by the owner
+    internal::post_cache<Symbol, StateBI_set> posts;
+    explicit worker(size_t post_cache_size) : posts(post_cache_size) {}
+  };
+  
+  const AutomatonA& a;
+  ImplementationB b_;
+  const AutomatonB& b = b_;
+  unsigned threads;
+  StateB_store macrostates;
+  pair_antichain antichain;
+  std::vector<std::unique_ptr<worker>> workers;
+  
+  unsigned bound;  // bound of the algorithm
+  unsigned generation = 0; // increased with every bound, dirty pairs of older generations are dropped
+  
+  std::atomic<unsigned long> pending; // pairs that are in a deque or being processed
+  std::atomic<unsigned long> pushes; // counts the pushed pairs, so idle workers notice new work
+  std::atomic<unsigned> idle_workers;
+  std::mutex idle_mutex;
+  std::condition_variable idle;
+  std::atomic<bool> found;
+  std::mutex result_mutex;
+  inclusion_result<Symbol> result;
+  
+  StateBI_set prune(const StateBI_set& b, StateBI_set& un_pruned, unsigned k, bool dirty) {
+    bool too_large = false;
+    for(const StateB& state : b->states()) {
+      if (state->size() > k) {
+        too_large = true;
+        break;
+      }
+    }
+    if (!too_large)
+      return b;
+    if (!dirty)
+      un_pruned = b;
+    StateB_set pruned;
+    for(const StateB& state : b->states()) {
+      if (state->size() <= k)
+        pruned.insert(state);
+    }
+    return macrostates.intern(std::move(pruned));
+  }
+  
+  void push(unsigned id, pair&& p) {
+    worker& w = *workers[id];
+    ++pending;
+    {
+      std::lock_guard<std::mutex> lock(w.mutex);
+      w.pairs.push_back(std::move(p));
+    }
+    ++pushes;
+    if (idle_workers > 0) {
+      std::lock_guard<std::mutex> lock(idle_mutex);
+      idle.notify_one();
+    }
+  }
+  
+  /**
+   * @brief Wakes all idle workers, when the search is finished or a counter-example was found
+   */
+  void wake_all() {
+    std::lock_guard<std::mutex> lock(idle_mutex);
+    idle.notify_all();
+  }
+  
+  /**
+   * @brief Takes a pair from the own deque or steals one and processes it
+   * 
+   * @return False if all deques were empty
+   */
+  bool step(unsigned id) {
+    {
+      worker& w = *workers[id];
+      std::unique_lock<std::mutex> lock(w.mutex);
+      if (!w.pairs.empty()) {
+        pair current = std::move(w.pairs.back());
+        w.pairs.pop_back();
+        lock.unlock();
+        process(id, current);
+        return true;
+      }
+    }
+    for (unsigned i = 1; i < threads; ++i) {
+      worker& victim = *workers[(id + i) % threads];
+      std::unique_lock<std::mutex> lock(victim.mutex);
+      if (!victim.pairs.empty()) {
+        pair current = std::move(victim.pairs.front());
+        victim.pairs.pop_front();
+        lock.unlock();
+        process(id, current);
+        return true;
+      }
+    }
+    return false;
+  }
+  
+  /**
+   * @brief Returns the successor macrostate of states for sigma (cached per thread)
+   */
+  StateBI_set post(worker& w, const StateBI_set& states, const Symbol& sigma) {
+    StateBI_set result;
+    if (w.posts.find(states->id(), sigma, result))
+      return result;
+    StateB_set successors;
+    b.successors(states->states(), sigma, successors);
+    result = macrostates.intern(std::move(successors));
+    w.posts.insert(states->id(), sigma, result);
+    return result;
+  }
+  
+  void process(unsigned id, const pair& current) {
+    // dirty pair from before the last bound increase
+    if (current.dirty && current.generation != generation)
+      return;
+    if (a.is_final_state(current.a) && !b.is_final_state(current.b->states())) {
+      std::lock_guard<std::mutex> lock(result_mutex);
+      if (!found) {
+        found = true;
+        result.included = false;
+        if (current.cex_chain)
+          result.counter_example = current.cex_chain->to_vector();
+        if (current.dirty)
+          result.bound_hit = true;
+      }
+      return;
+    }
+    worker& w = *workers[id];
+    Symbol_vector next_symbols;
+    a.next_symbols(current.a, next_symbols);
+    for (const Symbol& sigma : next_symbols) {
+      StateA_vector states_a = a.successors(current.a, sigma);
+      StateBI_set unpruned;
+      StateBI_set states_b;
+      if (a.is_epsilon(sigma)) states_b = current.b; else {
+        states_b = prune(post(w, current.b, sigma), unpruned, bound, current.dirty);
+      }
+      for (const StateA& state_a : states_a) {
+        pair next(state_a, states_b, current.cex_chain, sigma);
+        next.dirty = current.dirty || unpruned;
+        next.generation = generation;
+        if (unpruned) w.before_dirty.push_back(pair(state_a, unpruned, current.cex_chain, sigma));
+        if (antichain.add_if_absent(next.a, next.b, next.dirty))
+          push(id, std::move(next));
+      }
+    }
+  }
+  
+  void work(unsigned id) {
+    while (!found) {
+      unsigned long seen = pushes;
+      if (step(id)) {
+        if (--pending == 0 || found)
+          wake_all();
+        continue;
+      }
+      if (pending == 0) break;
+      // idle until a pair is pushed (it may have been pushed after step() looked), the search is finished or a counter-example found
+      std::unique_lock<std::mutex> lock(idle_mutex);
+      ++idle_workers;
+      idle.wait(lock, [&] { return found || pending == 0 || pushes != seen; });
+      --idle_workers;
+    }
+  }
+  
+  void initial_states() {
+    StateB_set initial_b;
+    b.initial_states(initial_b);
+    StateBI_set states_b = macrostates.intern(std::move(initial_b));
+    for(StateA state_a : a.initial_states()) {
+      antichain.add_unchecked(state_a, states_b, false);
+      push(0, pair(state_a, states_b));
+    }
+  }
+
+public:
+
+  /**
+    * @brief Constructor that initialises the language inclusion algorithm.
+    * 
+    * @param a The automaton a
+    * @param ib The automaton b
+    * @param initial_bound The starting bound
+    * @param independence The independence (if there is no default constructor)
+    * @param threads The number of threads (0 uses one thread per core)
+    * @param post_cache_size The maximal number of successor macrostates of b that are cached by each thread (0 disables the cache)
+    * 
+    */
+  parallel_antichain_algo_ind(const AutomatonA& a, const InnerAutomatonB& ib, unsigned initial_bound = 2, const Independence& independence = Independence(),
+                              unsigned threads = 0, size_t post_cache_size = internal::default_post_cache_size) :
+    a(a), b_(ib, independence), threads(threads ? threads : std::max(1u, std::thread::hardware_concurrency())),
+    macrostates(this->threads * 4), antichain(this->threads * 16), bound(initial_bound), pending(0), pushes(0), idle_workers(0), found(false) {
+      for (unsigned i = 0; i < this->threads; ++i)
+        workers.emplace_back(new worker(post_cache_size));
+      initial_states();
+  }
+  
+  /**
+    * @brief Returns the current bound.
+    * 
+    */
+  unsigned get_bound() {
+    return bound;
+  }
+  
+  /**
+    * @brief Returns the number of threads.
+    */
+  inline unsigned get_threads() const {
+    return threads;
+  }
+  
+  /**
+    * @brief Incleases the bound of the language inclusion check.
+    * 
+    * This causes a partial restart of the language inclusion check the next time run()
+    * is called and run may find the same counter-example again. It must not be called while run() is running.
+    */
+  void increase_bound(unsigned new_bound) {
+    if (new_bound < bound) throw std::logic_error("New bound smaller than old bound.");
+    if (new_bound == bound) return;
+    bound = new_bound;
+    ++generation;
+    antichain.clean_dirty();
+    
+    unsigned next = 0;
+    for (auto& w : workers) {
+      for (pair& e : w->before_dirty) {
+        if (antichain.add_if_absent(e.a, e.b, false)) {
+          push(next, std::move(e));
+          next = (next + 1) % threads;
+        }
+      }
+      w->before_dirty.clear();
+    }
+  }
+  
+  /**
+    * @brief Run the language inclusion.
+    * 
+    * Can be called several time to obtain several counter-examples.
+    * 
+    * @return Language inclusion result and a counter-example trace (if applicable)
+    */
+  inclusion_result<Symbol> run()
+  {
+    result = inclusion_result<Symbol>();
+    result.included = true;
+    result.bound_hit = false;
+    result.max_bound = bound;
+    found = false;
+    
+    std::vector<std::thread> pool;
+    for (unsigned i = 1; i < threads; ++i)
+      pool.emplace_back(&parallel_antichain_algo_ind::work, this, i);
+    work(0);
+    for (std::thread& t : pool)
+      t.join();
+
+#ifdef DEBUG_PRINTING
+    if (DEBUG_PRINTING>=1) std::cout << "threads: " << threads << "; seen states: " << antichain.size() << "; macrostates: " << macrostates.size() << std::endl;
+    
+    if (DEBUG_PRINTING >= 4) {
+      antichain.print(std::cout, a.state_printer(), b.state_printer());
+    }
+#endif
+
+    return result;
+  }
+  
+};
+
+}
+
+#endif // LIMI_PARALLEL_ANTICHAINALGO_IND_H
@@ -0,0 +1,171 @@
+/*
+ * Copyright 2016, IST Austria
+ *
+ * This file is part of Limi.
+ *
+ * Limi is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Limi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Limi.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIMI_REDUCE_H
+#define LIMI_REDUCE_H
+
+#include <memory>
+#include <vector>
+#include <deque>
+#include <algorithm>
+#include "automaton.h"
+#include "explicit_automaton.h"
+#include "internal/simulation_refinement.h"
+
+namespace Limi {
+
+/**
+  * @brief Reduces an automaton with its maximal forward simulation.
+  *
+  * The automaton is explored (see \ref explicit_automaton) and then reduced in three steps that preserve the language:
+  *
+  * - States that simulate each other are merged. A merged state is printed as the first of its states.
+  * - Transitions to little brothers are removed: if p -σ-> q and p -σ-> q' where q' simulates q but not the other way round,
+  *   the transition to q is not needed. The same is done for initial states.
+  * - States that are no longer reachable are removed.
+  *
+  * Epsilon transitions are treated like any other symbol, so the reduced automaton can be used as automaton A or B of
+  * \ref antichain_algo and \ref antichain_algo_ind. The printers of the original automaton are used, so it must stay alive
+  * as long as the reduced automaton is printed.
+  *
+  * @param aut The automaton to reduce
+  * @return The reduced automaton
+  */
+template <class State, class Symbol, class Implementation>
+std::unique_ptr<explicit_automaton<State, Symbol>> reduce(const automaton<State, Symbol, Implementation>& aut) {
+  using explicit_type = explicit_automaton<State, Symbol>;
+  using transition = typename explicit_type::transition;
+  using transition_vector = typename explicit_type::transition_vector;
+
+  explicit_type expl(aut);
+  const unsigned n = expl.size();
+  internal::partition_relation sim = internal::refine_simulation(expl, false);
+
+  // merge equivalent states
+  const unsigned none = n;
+  std::vector<unsigned> cls(n, none);
+  std::vector<unsigned> representative;
+  for (unsigned q = 0; q < n; ++q) {
+    if (cls[q] != none) continue;
+    cls[q] = representative.size();
+    sim.for_each(q, [&](size_t r) {
+      if (cls[r] == none && sim.get(r, q))
+        cls[r] = representative.size();
+    });
+    representative.push_back(q);
+  }
+  const unsigned m = representative.size();
+  std::vector<transition_vector> transitions(m);
+  for (unsigned q = 0; q < n; ++q) {
+    for (const transition& t : expl.transitions(q))
+      transitions[cls[q]].emplace_back(t.symbol, cls[t.target]);
+  }
+
+  // keeps the states of list (sorted) that are not strictly simulated by another state in the list
+  auto strict = [&](unsigned c1, unsigned c2) { return sim.get(representative[c1], representative[c2]); };
+  auto prune = [&](std::vector<unsigned>& list) {
+    std::vector<unsigned> kept;
+    for (unsigned c : list) {
+      bool little = false;
+      for (unsigned c2 : list) {
+        if (c2 != c && strict(c, c2)) {
+          little = true;
+          break;
+        }
+      }
+      if (!little) kept.push_back(c);
+    }
+    list.swap(kept);
+  };
+
+  std::vector<unsigned> initial;
+  for (unsigned q = 0; q < n; ++q) {
+    if (expl.is_initial(q)) initial.push_back(cls[q]);
+  }
+  std::sort(initial.begin(), initial.end());
+  initial.erase(std::unique(initial.begin(), initial.end()), initial.end());
+  prune(initial);
+
+  std::vector<unsigned> targets;
+  for (transition_vector& list : transitions) {
+    std::sort(list.begin(), list.end());
+    list.erase(std::unique(list.begin(), list.end()), list.end());
+    transition_vector kept;
+    for (size_t i = 0; i < list.size();) {
+      size_t end = i;
+      targets.clear();
+      while (end < list.size() && list[end].symbol == list[i].symbol)
+        targets.push_back(list[end++].target);
+      prune(targets);
+      for (unsigned t : targets)
+        kept.emplace_back(list[i].symbol, t);
+      i = end;
+    }
+    list.swap(kept);
+  }
+
+  // renumber the reachable states
+  std::vector<unsigned> number(m, none);
+  std::vector<unsigned> order;
+  std::deque<unsigned> frontier;
+  for (unsigned c : initial) {
+    number[c] = order.size();
+    order.push_back(c);
+    frontier.push_back(c);
+  }
+  while (!frontier.empty()) {
+    unsigned c = frontier.front();
+    frontier.pop_front();
+    for (const transition& t : transitions[c]) {
+      if (number[t.target] == none) {
+        number[t.target] = order.size();
+        order.push_back(t.target);
+        frontier.push_back(t.target);
+      }
+    }
+  }
+
+  std::vector<State> states;
+  std::vector<bool> final;
+  std::vector<transition_vector> new_transitions;
+  for (unsigned c : order) {
+    unsigned rep = representative[c];
+    states.push_back(expl.state(rep));
+    final.push_back(expl.is_final_state(rep));
+    new_transitions.emplace_back();
+    for (const transition& t : transitions[c])
+      new_transitions.back().emplace_back(t.symbol, number[t.target]);
+  }
+  std::vector<unsigned> new_initial;
+  for (unsigned c : initial)
+    new_initial.push_back(number[c]);
+  std::vector<Symbol> symbols;
+  std::vector<bool> epsilon;
+  for (unsigned s = 0; s < expl.symbol_count(); ++s) {
+    symbols.push_back(expl.symbol(s));
+    epsilon.push_back(expl.epsilon(s));
+  }
+
+  return std::unique_ptr<explicit_type>(new explicit_type(states, symbols, epsilon, new_initial, final, new_transitions,
+                                                          aut.state_printer(), aut.symbol_printer()));
+}
+
+}
+
+#endif // LIMI_REDUCE_H
@@ -23,6 +23,8 @@
 #include <unordered_set>
 #include <list>
 #include <algorithm>
+#include <vector>
+#include <limits>
 #include "generics.h"
 
 namespace Limi {
@@ -69,6 +71,76 @@ struct counterexample_chain {
 private:
 };
 
+/**
+  * @brief Stores the paths through the automaton like \ref counterexample_chain, but in one vector.
+  * 
+  * Every path is a record of its last symbol and the index of the record of its prefix. A path is referred to by
+  * the index of its last record and the empty path by \ref none. The records are freed all at once when the arena
+  * is destroyed, and no reference counting is needed when the paths are copied.
+  * 
+  * If tracking is switched off no records are stored and every path is empty.
+  * 
+  * @tparam Symbol The type of symbols in the paths
+  * 
+  */
+template<class Symbol>
+class counterexample_arena {
+  struct record {
+    Symbol symbol;
+    unsigned parent;
+  };
+  std::vector<record> records;
+  bool tracking_ = true;
+public:
+  /**
+   * @brief The index of the empty path
+   */
+  static const unsigned none = std::numeric_limits<unsigned>::max();
+  
+  /**
+   * @brief Appends symbol to the path parent and returns the index of the new path
+   */
+  inline unsigned add(const Symbol& symbol, unsigned parent) {
+    if (!tracking_) return none;
+    records.push_back(record{symbol, parent});
+    return records.size() - 1;
+  }
+  
+  /**
+   * @brief Returns the symbols of a path (first symbol first)
+   */
+  std::vector<Symbol> to_vector(unsigned index) const {
+    std::vector<Symbol> result;
+    while (index != none) {
+      result.push_back(records[index].symbol);
+      index = records[index].parent;
+    }
+    std::reverse(result.begin(), result.end());
+    return result;
+  }
+  
+  /**
+   * @brief Switches tracking on or off. Paths that were added before stay valid.
+   */
+  inline void set_tracking(bool tracking) {
+    tracking_ = tracking;
+  }
+  
+  inline bool tracking() const {
+    return tracking_;
+  }
+  
+  /**
+   * @brief The number of records stored
+   */
+  inline size_t size() const {
+    return records.size();
+  }
+};
+
+template<class Symbol>
+const unsigned counterexample_arena<Symbol>::none;
+
 
 /**
  * @brief The result of the language inclusion test.
@@ -126,6 +198,25 @@ struct inclusion_result {
    * 
    */
   unsigned max_bound = 0;
+  
+  /**
+   * @brief Counters of the work and the allocations of one run.
+   * 
+   * Only used by the sequential algorithms (\ref Limi::antichain_algo, \ref Limi::antichain_algo_ind,
+   * \ref Limi::antichain_algo_backward, \ref Limi::congruence_algo and \ref Limi::equivalence_algo)
+   * 
+   */
+  struct counters {
+    unsigned long pairs = 0; // pairs taken from the frontier
+    unsigned long macrostates = 0; // macrostates allocated (successors that were not seen before)
+    unsigned long traces = 0; // records added to the counter-example arena
+    unsigned long buffer_growths = 0; // times a scratch buffer had to allocate more memory
+  };
+  
+  /**
+   * @brief The counters of the run that produced this result.
+   */
+  counters statistics;
     
   /**
    * @brief Print this result.
@@ -149,6 +240,49 @@ struct inclusion_result {
   }
 };
 
+/**
+ * @brief The result of the language equivalence test.
+ * 
+ */
+template <class Symbol>
+struct equivalence_result {
+  /**
+   * @brief True if automata A and B accept the same language.
+   */
+  bool equivalent = false;
+  /**
+   * @brief Only if \ref equivalent is false. True if the counter-example is accepted by A and not by B,
+   * false if it is accepted by B and not by A.
+   */
+  bool in_a = false;
+  /**
+   * @brief A word accepted by exactly one of the automata (only if \ref equivalent is false).
+   */
+  std::vector<Symbol> counter_example;
+  
+  /**
+   * @brief The counters of the run that produced this result.
+   */
+  typename inclusion_result<Symbol>::counters statistics;
+  
+  /**
+   * @brief Print this result.
+   * 
+   * @param stream The stream to print to.
+   * @param symbol_printer The printer to print out the counter-example if any.
+   */
+  void print_long(std::ostream& stream, const printer_base<Symbol>& symbol_printer) {
+    if (equivalent)
+      stream << "Equivalent" << std::endl;
+    else {
+      stream << "Not Equivalent; " << (in_a ? "A not included in B" : "B not included in A") << std::endl;
+      for (const auto& s : counter_example) {
+        stream << symbol_printer(s);
+        stream << std::endl;
+      }
+    }
+  }
+};
 
 }
 
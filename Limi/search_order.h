@@ -0,0 +1,57 @@
+/*
+ * Copyright 2016, IST Austria
+ *
+ * This file is part of Limi.
+ *
+ * Limi is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Limi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Limi.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIMI_SEARCH_ORDER_H
+#define LIMI_SEARCH_ORDER_H
+
+namespace Limi {
+
+/**
+ * @brief The order in which the language inclusion algorithms explore the pairs (a,b).
+ *
+ * The order does not change the answer, only the time it takes and the counter-example that is found.
+ */
+enum class search_order {
+  /**
+   * @brief The pair found last is explored first (the default).
+   *
+   * Uses the least memory and often finds a counter-example quickly, but the counter-example may be long.
+   */
+  depth_first,
+  /**
+   * @brief The pairs are explored in the order they are found.
+   *
+   * The counter-example is one of the shortest ones.
+   */
+  breadth_first,
+  /**
+   * @brief The pair with the smallest macrostate of B is explored first.
+   *
+   * Small macrostates are the ones that are most likely to miss a final state.
+   */
+  smallest_first,
+  /**
+   * @brief The pair with the smallest value of a heuristic given by the user is explored first.
+   */
+  heuristic
+};
+
+}
+
+#endif // LIMI_SEARCH_ORDER_H
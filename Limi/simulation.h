@@ -0,0 +1,244 @@
+/*
+ * Copyright 2016, IST Austria
+ *
+ * This file is part of Limi.
+ *
+ * Limi is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Limi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Limi.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIMI_SIMULATION_H
+#define LIMI_SIMULATION_H
+
+#include <unordered_map>
+#include <vector>
+#include <functional>
+#include "automaton.h"
+#include "explicit_automaton.h"
+#include "internal/bitset.h"
+#include "internal/simulation_refinement.h"
+
+namespace Limi {
+
+/**
+ * @brief A forward (or backward) simulation preorder on the states of an automaton.
+ *
+ * The relation q ⪯ r (r simulates q) requires that r is final if q is final and that for every transition
+ * q -σ-> q' there is a transition r -σ-> r' with q' ⪯ r'. The language of q is then included in the language of r.
+ * Backward simulations are the same on the reversed automaton with initial instead of final states.
+ * Every state simulates itself, only the other pairs are stored.
+ *
+ * The states in the relation are numbered and every state keeps a bitset of the states that simulate it,
+ * so \ref simulates() needs two hash lookups and a bit test.
+ *
+ * The maximal simulations of an automaton are computed by \ref forward_simulation() and \ref backward_simulation().
+ * Pairs can also be added by hand with \ref add(). The class does not check the relation. The pairs that are added must 
+ * form a simulation and the relation must be transitive (which is the case for the maximal simulation).
+ *
+ * @tparam State The type of states
+ */
+template <class State, class Hash = std::hash<State>, class Compare = std::equal_to<State>>
+class simulation {
+public:
+  using State_vector = std::vector<State>;
+
+private:
+  std::unordered_map<State, unsigned, Hash, Compare> index_;
+  std::vector<internal::packed_set> larger_; // the indices of the states simulating a state
+  std::vector<State_vector> simulators_;
+  std::vector<State_vector> simulated_;
+  unsigned pairs_ = 0;
+  const State_vector empty_;
+
+  inline unsigned id(const State& state) {
+    auto it = index_.insert(std::make_pair(state, index_.size()));
+    if (it.second) {
+      larger_.emplace_back();
+      simulators_.emplace_back();
+      simulated_.emplace_back();
+    }
+    return it.first->second;
+  }
+
+public:
+  simulation() = default;
+
+  /**
+   * @brief Adds the pair smaller ⪯ larger
+   */
+  void add(const State& smaller, const State& larger) {
+    if (Compare()(smaller, larger)) return;
+    unsigned s = id(smaller);
+    unsigned l = id(larger);
+    if (larger_[s].contains(l)) return;
+    larger_[s].insert(l);
+    simulators_[s].push_back(larger);
+    simulated_[l].push_back(smaller);
+    ++pairs_;
+  }
+
+  /**
+   * @brief Tests if larger simulates smaller
+   */
+  inline bool simulates(const State& larger, const State& smaller) const {
+    if (Compare()(smaller, larger)) return true;
+    auto s = index_.find(smaller);
+    if (s == index_.end()) return false;
+    auto l = index_.find(larger);
+    return l != index_.end() && larger_[s->second].contains(l->second);
+  }
+
+  /**
+   * @brief Returns all states that simulate state (except state itself)
+   */
+  inline const State_vector& simulators(const State& state) const {
+    auto it = index_.find(state);
+    return it == index_.end() ? empty_ : simulators_[it->second];
+  }
+
+  /**
+   * @brief Returns all states simulated by state (except state itself)
+   */
+  inline const State_vector& simulated(const State& state) const {
+    auto it = index_.find(state);
+    return it == index_.end() ? empty_ : simulated_[it->second];
+  }
+
+  /**
+   * @brief Tests if two states simulate each other
+   */
+  inline bool equivalent(const State& state1, const State& state2) const {
+    return simulates(state1, state2) && simulates(state2, state1);
+  }
+
+  /**
+   * @brief Returns the number of pairs in the relation (without the identity)
+   */
+  inline unsigned size() const {
+    return pairs_;
+  }
+
+  /**
+   * @brief Tests if every state of small is simulated by some state of large.
+   *
+   * Then the language of the set small is included in the language of the set large.
+   * With the identity relation this is the same as small ⊆ large.
+   */
+  template <class Set1, class Set2>
+  bool forall_exists(const Set1& small, const Set2& large) const {
+    for (const State& x : small) {
+      if (large.find(x) != large.end()) continue;
+      bool found = false;
+      for (const State& y : simulators(x)) {
+        if (large.find(y) != large.end()) {
+          found = true;
+          break;
+        }
+      }
+      if (!found) return false;
+    }
+    return true;
+  }
+
+  /**
+   * @brief Removes every state of the set that is simulated by another state of the set.
+   *
+   * The language of the set stays the same. Of several states that simulate each other one is kept.
+   */
+  template <class Set>
+  void minimize(Set& set) const {
+    if (pairs_ == 0) return;
+    for (auto it = set.begin(); it != set.end();) {
+      bool dominated = false;
+      for (const State& y : simulators(*it)) {
+        if (set.find(y) != set.end()) {
+          dominated = true;
+          break;
+        }
+      }
+      if (dominated)
+        it = set.erase(it);
+      else
+        ++it;
+    }
+  }
+};
+
+namespace internal {
+
+/**
+ * @brief Converts a relation on the indices of an explicit automaton to a relation on states
+ */
+template <class State, class Symbol, class StateOut, class F>
+simulation<StateOut> simulation_from_relation(const explicit_automaton<State, Symbol>& aut, const partition_relation& relation, F state) {
+  simulation<StateOut> result;
+  for (unsigned q = 0; q < aut.size(); ++q) {
+    relation.for_each(q, [&](size_t r) {
+      if (r != q) result.add(state(q), state(r));
+    });
+  }
+  return result;
+}
+
+}
+
+/**
+ * @brief Computes the maximal forward simulation of an explicit automaton.
+ *
+ * @return The relation on the state indices of the automaton
+ */
+template <class State, class Symbol>
+simulation<unsigned> forward_simulation(const explicit_automaton<State, Symbol>& aut) {
+  return internal::simulation_from_relation<State, Symbol, unsigned>(aut, internal::refine_simulation(aut, false), [](unsigned q) { return q; });
+}
+
+/**
+ * @brief Computes the maximal backward simulation of an explicit automaton.
+ *
+ * @return The relation on the state indices of the automaton
+ */
+template <class State, class Symbol>
+simulation<unsigned> backward_simulation(const explicit_automaton<State, Symbol>& aut) {
+  return internal::simulation_from_relation<State, Symbol, unsigned>(aut, internal::refine_simulation(aut, true), [](unsigned q) { return q; });
+}
+
+/**
+ * @brief Computes the maximal forward simulation of the reachable part of an automaton.
+ *
+ * The automaton is explored first (see \ref explicit_automaton). Epsilon transitions that are returned by the automaton 
+ * are treated like any other symbol, so the result can be used for the automaton A of \ref antichain_algo.
+ *
+ * @param aut The automaton
+ * @return The relation on the states of the automaton
+ */
+template <class State, class Symbol, class Implementation>
+simulation<State> forward_simulation(const automaton<State, Symbol, Implementation>& aut) {
+  explicit_automaton<State, Symbol> expl(aut);
+  return internal::simulation_from_relation<State, Symbol, State>(expl, internal::refine_simulation(expl, false), [&](unsigned q) { return expl.state(q); });
+}
+
+/**
+ * @brief Computes the maximal backward simulation of the reachable part of an automaton.
+ *
+ * @param aut The automaton
+ * @return The relation on the states of the automaton
+ */
+template <class State, class Symbol, class Implementation>
+simulation<State> backward_simulation(const automaton<State, Symbol, Implementation>& aut) {
+  explicit_automaton<State, Symbol> expl(aut);
+  return internal::simulation_from_relation<State, Symbol, State>(expl, internal::refine_simulation(expl, true), [&](unsigned q) { return expl.state(q); });
+}
+
+}
+
+#endif // LIMI_SIMULATION_H
@@ -0,0 +1,221 @@
+/*
+ * Copyright 2016, IST Austria
+ *
+ * This file is part of Limi.
+ *
+ * Limi is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Limi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Limi.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIMI_UNIVERSALITY_ALGO_H
+#define LIMI_UNIVERSALITY_ALGO_H
+
+#include "automaton.h"
+#include <vector>
+#include <unordered_set>
+#include <memory>
+#include <iostream>
+#include <stdexcept>
+#include "internal/set_antichain.h"
+#include "internal/macrostate.h"
+#include "internal/post_cache.h"
+#include "internal/frontier.h"
+#include "results.h"
+#include "internal/helpers.h"
+
+namespace Limi {
+
+/**
+  * @brief The antichain algorithm for universality: tests if an automaton accepts every word over an alphabet.
+  * 
+  * This is the special case of \ref antichain_algo where A accepts every word, but without A. Only the macrostates
+  * of B are explored, and they are kept in an \ref internal::set_antichain of the minimal macrostates (not the maximal
+  * ones): a subset of a macrostate accepts fewer words, so if it is universal the macrostate is too. A macrostate is
+  * therefore skipped if a subset of it was explored, and explored supersets of a new macrostate are dropped (together
+  * with their items in the frontier). A counter-example is found when a macrostate contains no final state.
+  * 
+  * The class already accepts the automaton as constructor argument and therefore cannot be reused for more
+  * than one query. The run() function runs until a counter-example is produced.
+  * Run can be called again to produce another counter-example.
+  * 
+  * @tparam Implementation The implementation class of the automaton
+  * 
+  */
+template <class Implementation>
+class universality_algo
+{
+  using State = typename Implementation::State_;
+  using Symbol = typename Implementation::Symbol_;
+  
+  using State_set = std::unordered_set<State>;
+  using State_store = internal::macrostate_store<State>;
+  using StateI_set = typename State_store::pstate;
+  using Symbol_vector = std::vector<Symbol>;
+  using Automaton = automaton<State, Symbol, Implementation>;
+  
+  using trace_arena = counterexample_arena<Symbol>;
+  
+  struct item {
+    StateI_set states;
+    unsigned trace; // the path to this macrostate in traces
+    item(StateI_set states, unsigned trace = trace_arena::none) : states(states), trace(trace) {}
+  };
+  
+  /**
+   * @brief Returns the successor macrostate of states for sigma (cached)
+   */
+  StateI_set post(const StateI_set& states, const Symbol& sigma) {
+    StateI_set result;
+    if (posts.find(states->id(), sigma, result))
+      return result;
+    State_set successors;
+    b.successors(states->states(), sigma, successors);
+    result = macrostates.intern(std::move(successors));
+    posts.insert(states->id(), sigma, result);
+    return result;
+  }
+  
+  void initial_states(State_set&& initial) {
+    StateI_set states = macrostates.intern(std::move(initial));
+    antichain.try_insert(states);
+    frontier.push_back(item(states));
+  }
+  
+  const Automaton& b;
+  Symbol_vector alphabet;
+  State_store macrostates;
+  internal::post_cache<Symbol, StateI_set> posts;
+  internal::set_antichain<State> antichain; // the minimal macrostates seen so far
+  trace_arena traces;
+  internal::frontier<item> frontier;
+
+public:
+
+  /**
+    * @brief Constructor that initialises the universality check from the initial states of the automaton.
+    * 
+    * @param b The automaton. It must not produce any epsilon transitions.
+    * @param alphabet The symbols of the words that must be accepted
+    * @param post_cache_size The maximal number of successor macrostates that are cached (0 disables the cache)
+    * 
+    */
+  universality_algo(const Automaton& b, const Symbol_vector& alphabet, size_t post_cache_size = internal::default_post_cache_size) :
+    b(b), alphabet(alphabet), posts(post_cache_size) {
+      if (!b.collapse_epsilon && !b.no_epsilon_produced) {
+        throw std::logic_error("For the automaton in the universality algorithm either collapse_epsilon must be true or no_epsilon_produced");
+      }
+      State_set initial;
+      b.initial_states(initial);
+      initial_states(std::move(initial));
+  }
+  
+  /**
+    * @brief Constructor that initialises the universality check from a given set of states.
+    * 
+    * The check then tests if every word is accepted from one of these states.
+    * 
+    * @param b The automaton. It must not produce any epsilon transitions.
+    * @param initial The states to start from
+    * @param alphabet The symbols of the words that must be accepted
+    * @param post_cache_size The maximal number of successor macrostates that are cached (0 disables the cache)
+    * 
+    */
+  universality_algo(const Automaton& b, const State_set& initial, const Symbol_vector& alphabet, size_t post_cache_size = internal::default_post_cache_size) :
+    b(b), alphabet(alphabet), posts(post_cache_size) {
+      if (!b.collapse_epsilon && !b.no_epsilon_produced) {
+        throw std::logic_error("For the automaton in the universality algorithm either collapse_epsilon must be true or no_epsilon_produced");
+      }
+      initial_states(State_set(initial));
+  }
+  
+  /**
+    * @brief Changes the order in which the macrostates are explored (see \ref search_order).
+    * 
+    * The smallest_first order takes the smallest macrostate first. The heuristic order is not supported.
+    */
+  void set_search_order(search_order order) {
+    if (order == search_order::heuristic)
+      throw std::logic_error("The universality algorithm does not support a heuristic search order");
+    if (order == search_order::smallest_first)
+      frontier.set_order(order, [](const item& i) { return static_cast<unsigned>(i.states->size()); });
+    else
+      frontier.set_order(order);
+  }
+  
+  /**
+    * @brief Switches the tracking of counter-examples on or off (it is on by default).
+    * 
+    * Without tracking the algorithm needs less memory, but the counter-example of the result is empty.
+    */
+  void set_track_counter_example(bool track) {
+    traces.set_tracking(track);
+  }
+  
+  /**
+    * @brief Run the universality check.
+    * 
+    * Can be called several time to obtain several counter-examples.
+    * 
+    * @return The result is included if every word is accepted, otherwise the counter-example is a rejected word
+    */
+  inclusion_result<Symbol> run()
+  {
+    inclusion_result<Symbol> result;
+    result.included = true;
+    result.bound_hit = false;
+    unsigned macrostates_before = macrostates.size();
+    size_t traces_before = traces.size();
+    
+    while (!frontier.empty()) {
+      const item current = frontier.pop();
+      // a subset of the macrostate was found after it was added
+      if (!antichain.stored(*current.states))
+        continue;
+      ++result.statistics.pairs;
+      
+      if (!b.is_final_state(current.states->states())) {
+        result.counter_example = traces.to_vector(current.trace);
+        result.included = false;
+        break;
+      }
+
+#ifdef DEBUG_PRINTING
+      if (DEBUG_PRINTING>=3) {
+        std::cout << "Next macrostate: ";
+        internal::print_set(current.states->states(), std::cout, b.state_printer());
+        std::cout << std::endl;
+      }
+#endif
+
+      for (const Symbol& sigma : alphabet) {
+        StateI_set states = post(current.states, sigma);
+        if (antichain.try_insert(states))
+          frontier.push(item(states, traces.add(sigma, current.trace)));
+      }
+    }
+    result.statistics.macrostates = macrostates.size() - macrostates_before;
+    result.statistics.traces = traces.size() - traces_before;
+
+#ifdef DEBUG_PRINTING
+    if (DEBUG_PRINTING>=1) std::cout << result.statistics.pairs << " rounds" << std::endl;
+    if (DEBUG_PRINTING>=1) std::cout << "macrostates: " << macrostates.size() << "; cached posts: " << posts.size() << std::endl;
+#endif
+
+    return result;
+  }
+  
+};
+
+}
+
+#endif // LIMI_UNIVERSALITY_ALGO_H
@@ -54,6 +54,19 @@ public:
     inner_automaton.symbols(s, symbols);
   }
   
+  inline void int_predecessors(const state& s, const symbol& sigma, State_vector& predecessors) const 
+  { 
+    inner_automaton.predecessors(s, sigma, predecessors);
+  }
+  
+  inline void int_prev_symbols(const state& s, Symbol_vector& symbols) const { 
+    inner_automaton.prev_symbols(s, symbols);
+  }
+  
+  inline void int_final_states(State_vector& states) const { 
+    inner_automaton.final_states(states);
+  }
+  
   // PRINTERS: We need to override these because the printers' constructors need arguments
   inline const Limi::printer_base<state>* int_state_printer() const { return new Limi::printer<state>(inner_automaton); }
   
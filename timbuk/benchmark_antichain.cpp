@@ -0,0 +1,125 @@
+/*
+ * Copyright 2016, IST Austria
+ *
+ * This file is part of Limi.
+ *
+ * Limi is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Limi is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Limi.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Scalability benchmark of the concurrent antichain.
+// The same random insertions are split over 1, 2, ..., N threads and the throughput is printed for every number of threads.
+
+#include <Limi/internal/concurrent_antichain.h>
+#include <Limi/internal/macrostate.h>
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace Limi {
+  // the states of the workload are numbered from 0 to b_states
+  template<> struct dense_index<unsigned> {
+    static constexpr bool value = true;
+    static inline size_t index(unsigned state) { return state; }
+  };
+}
+
+using store = Limi::internal::macrostate_store<unsigned>;
+using pair_antichain = Limi::internal::concurrent_antichain<unsigned, unsigned>;
+
+// size of the workload
+const unsigned a_states = 2000;
+const unsigned b_states = 64;
+const unsigned max_set_size = 8;
+const unsigned macrostates = 20000;
+
+struct operation {
+  unsigned a;
+  unsigned b; // index into the macrostates
+};
+
+/**
+ * @brief Inserts all pairs with the given number of threads
+ *
+ * @return The time in seconds
+ */
+double run(const vector<store::pstate>& sets, const vector<operation>& operations, unsigned threads, unsigned& added) {
+  pair_antichain antichain(threads * 16);
+  atomic<unsigned> count(0);
+  auto work = [&](unsigned id) {
+    unsigned local = 0;
+    for (size_t i = id; i < operations.size(); i += threads) {
+      if (antichain.add_if_absent(operations[i].a, sets[operations[i].b]))
+        ++local;
+    }
+    count += local;
+  };
+
+  auto start = chrono::steady_clock::now();
+  vector<thread> pool;
+  for (unsigned i = 1; i < threads; ++i)
+    pool.emplace_back(work, i);
+  work(0);
+  for (thread& t : pool)
+    t.join();
+  auto stop = chrono::steady_clock::now();
+
+  added = count;
+  return chrono::duration<double>(stop - start).count();
+}
+
+int main(int argc, const char **argv) {
+  unsigned max_threads = argc > 1 ? stoul(argv[1]) : max(1u, thread::hardware_concurrency());
+  unsigned count = argc > 2 ? stoul(argv[2]) : 300000;
+  if (max_threads == 0 || argc > 3) {
+    cerr << "Usage: benchmark_antichain [threads] [operations]" << endl;
+    return 1;
+  }
+
+  mt19937 random(42);
+  store macrostate_store;
+  vector<store::pstate> sets;
+  uniform_int_distribution<unsigned> set_size(1, max_set_size);
+  uniform_int_distribution<unsigned> b_state(0, b_states - 1);
+  for (unsigned i = 0; i < macrostates; ++i) {
+    store::b_set set;
+    for (unsigned j = set_size(random); j > 0; --j)
+      set.insert(b_state(random));
+    sets.push_back(macrostate_store.intern(std::move(set)));
+  }
+
+  vector<operation> operations;
+  uniform_int_distribution<unsigned> a_state(0, a_states - 1);
+  uniform_int_distribution<unsigned> set(0, macrostates - 1);
+  for (unsigned i = 0; i < count; ++i)
+    operations.push_back(operation{a_state(random), set(random)});
+
+  cout << "threads  time (s)  Mops/s  speedup  added" << endl;
+  double base = 0;
+  for (unsigned threads = 1; threads <= max_threads; ++threads) {
+    unsigned added;
+    double time = run(sets, operations, threads, added);
+    if (threads == 1) base = time;
+    cout << setw(7) << threads << setw(10) << setprecision(3) << fixed << time << setw(8) << count / time / 1e6
+         << setw(9) << base / time << setw(7) << added << endl;
+  }
+  return 0;
+}
@@ -28,7 +28,17 @@
 #include <Limi/reachable.h>
 #include <Limi/antichain_algo_ind.h>
 #include <Limi/antichain_algo.h>
+#include <Limi/b_context.h>
+#include <Limi/antichain_algo_backward.h>
+#include <Limi/congruence_algo.h>
+#include <Limi/equivalence_algo.h>
+#include <Limi/universality_algo.h>
 #include <Limi/list_automaton.h>
+#include <Limi/simulation.h>
+#include <Limi/explicit_automaton.h>
+#include <Limi/reduce.h>
+#include <Limi/parallel_antichain_algo.h>
+#include <Limi/parallel_antichain_algo_ind.h>
 
 using namespace timbuk;
 
@@ -44,6 +54,41 @@ void all() {
   Limi::timbuk_printer<timbuk::state,timbuk::symbol,timbuk::automaton> tp(ind);
   Limi::antichain_algo_ind<automaton, automaton> aai(aut,aut,2,ind);
   Limi::antichain_algo<automaton, automaton> aa(aut,aut);
+  aa.set_search_order(Limi::search_order::heuristic, [](const timbuk::state&, const std::unordered_set<timbuk::state>& b) { return b.size(); });
+  aai.set_search_order(Limi::search_order::breadth_first);
+  aa.set_track_counter_example(false);
+  aa.set_incremental(true);
+  aa.run();
+  aa.states_changed(std::vector<timbuk::state>{0});
+  Limi::antichain_algo_backward<automaton, automaton> aab(aut,aut);
+  Limi::congruence_algo<automaton, automaton> ca(aut,aut);
+  ca.set_search_order(Limi::search_order::smallest_first);
+  ca.set_track_counter_example(false);
+  ca.run();
+  Limi::equivalence_algo<automaton, automaton> ea(aut,aut);
+  ea.set_search_order(Limi::search_order::breadth_first);
+  ea.run();
+  Limi::universality_algo<automaton> ua(aut, aut.next_symbols(0));
+  ua.set_search_order(Limi::search_order::smallest_first);
+  ua.run();
+  Limi::universality_algo<automaton> ua2(aut, automaton::State_set(), aut.next_symbols(0));
+  Limi::simulation<timbuk::state> sim = Limi::forward_simulation(aut);
+  Limi::simulation<timbuk::state> bsim = Limi::backward_simulation(aut);
+  Limi::antichain_algo<automaton, automaton> aas(aut,aut,sim,sim);
+  Limi::b_context<automaton> context(aut);
+  Limi::antichain_algo<automaton, automaton> aac(aut,context);
+  Limi::antichain_algo<automaton, automaton> aacs(aut,context,sim);
+  Limi::b_context<automaton> context_sim(aut,sim);
+  Limi::explicit_automaton<timbuk::state, timbuk::symbol> expl(aut);
+  Limi::simulation<unsigned> esim = Limi::forward_simulation(expl);
+  auto reduced = Limi::reduce(aut);
+  Limi::parallel_antichain_algo<automaton, automaton> paa(aut,aut,2);
+  Limi::parallel_antichain_algo_ind<automaton, automaton> paai(aut,aut,2,ind,2);
   std::list<timbuk::symbol> sy_list;
   Limi::list_automaton<timbuk::symbol> list(sy_list.begin(), sy_list.end(), aut.symbol_printer());
+  for (const timbuk::symbol& sigma : aut.prev_symbols(0))
+    aut.predecessors(0, sigma);
+  expl.predecessors(0, expl.symbol(0));
+  for (unsigned state : list.initial_states())
+    list.predecessors(state, list.prev_symbols(state).front());
 }
\ No newline at end of file
@@ -25,10 +25,23 @@
 
 #include <Limi/antichain_algo_ind.h>
 #include <Limi/antichain_algo.h>
+#include <Limi/antichain_algo_backward.h>
+#include <Limi/congruence_algo.h>
+#include <Limi/equivalence_algo.h>
+#include <Limi/universality_algo.h>
 #include <Limi/dot_printer.h>
 #include <Limi/list_automaton.h>
+#include <Limi/reduce.h>
+#include <Limi/parallel_antichain_algo.h>
+#include <Limi/parallel_antichain_algo_ind.h>
 
 #include <chrono>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <fstream>
+#include <sstream>
+#include <memory>
 
 #include <string>
 #include <iomanip>
@@ -36,9 +49,33 @@
 
 using namespace std;
 
+/**
+ * @brief The options of the language inclusion check
+ */
+struct options {
+  unsigned threads = 1; // more than one thread uses the parallel algorithms
+  Limi::search_order order = Limi::search_order::depth_first; // only used by the sequential algorithms
+  bool backward = false; // use the backward algorithm (only without independence relation)
+  bool congruence = false; // use the up to congruence algorithm (only without independence relation)
+};
+
 int main_wrapped(int argc, const char **argv);
-Limi::inclusion_result<timbuk::symbol> compare_no_independence(const timbuk::automaton& a, const timbuk::automaton& b);
-Limi::inclusion_result<timbuk::symbol> compare_with_independence(const timbuk::automaton& a, const timbuk::automaton& b, const timbuk::symbol_table& st);
+template <class AutomatonA, class AutomatonB>
+Limi::inclusion_result<timbuk::symbol> compare(const AutomatonA& a, const AutomatonB& b, const timbuk::symbol_table& st, const options& opt);
+template <class AutomatonA, class AutomatonB>
+Limi::inclusion_result<timbuk::symbol> compare_no_independence(const AutomatonA& a, const AutomatonB& b, const options& opt);
+template <class AutomatonA, class AutomatonB>
+Limi::inclusion_result<timbuk::symbol> compare_with_independence(const AutomatonA& a, const AutomatonB& b, const timbuk::symbol_table& st, const options& opt);
+template <class AutomatonA, class AutomatonB>
+Limi::equivalence_result<timbuk::symbol> equivalent(const AutomatonA& a, const AutomatonB& b, const timbuk::symbol_table& st, const options& opt);
+template <class Automaton>
+Limi::inclusion_result<timbuk::symbol> universal(const Automaton& b, const timbuk::symbol_table& st, const options& opt);
+int run_batch(const string& manifest, bool reduce, bool equivalence, const options& opt);
+int run_grow(timbuk::parsed_automaton& aut, const timbuk::automaton& a, const timbuk::automaton& b, const string& grow, timbuk::symbol_table& st, bool other_check, const options& opt);
+template <class AutomatonA, class AutomatonB>
+string check_pair(const AutomatonA& a, const AutomatonB& b, const timbuk::symbol_table& st, const options& opt, bool equivalence);
+template <class Algorithm, class AutomatonA, class AutomatonB>
+Limi::inclusion_result<timbuk::symbol> run_with_bound(Algorithm& algo, const AutomatonA& a, const AutomatonB& b, const timbuk::symbol_table& st);
 
 // some arbitrary value indicating 
 const unsigned max_bound = 10;
@@ -50,7 +87,7 @@ const unsigned initial_bound = 2; // 1 or 2 is usually a good start
 int main(int argc, const char **argv) {
   try {
     return main_wrapped(argc, argv);
-  } catch (std::exception e) {
+  } catch (std::exception& e) {
     cerr << "Exception thrown: " << e.what() << endl;
     return 2;
   }
@@ -60,8 +97,97 @@ int main(int argc, const char **argv) {
  * @brief Actual main function
  */
 int main_wrapped(int argc, const char **argv) {
-  if (argc < 3) {
-    cerr << "Two arguments are needed: The two automata to compare." << endl;
+  // options: -r reduces the automata with simulations before the comparison
+  // -j N uses N threads (0 = one per core)
+  // -s dfs|bfs|small chooses the search order (depth-first, breadth-first or smallest macrostate first)
+  // -b explores the automata backwards from the final states
+  // -c uses bisimulation up to congruence (like HKC) instead of antichains
+  // -e checks if the automata are equivalent (both inclusions in one run)
+  // -u checks if a single automaton accepts every word
+  // -g FILE checks A against B, then adds the transitions of FILE to A and resumes the check
+  // -m FILE checks all pairs of automata listed in FILE (one pair per line), -j is then the number of pairs checked at the same time
+  bool reduce = false;
+  bool equivalence = false;
+  bool universality = false;
+  string manifest;
+  string grow;
+  options opt;
+  while (argc > 1 && argv[1][0] == '-') {
+    string option(argv[1]);
+    if (option == "-r") {
+      reduce = true;
+    } else if (option == "-b") {
+      opt.backward = true;
+    } else if (option == "-c") {
+      opt.congruence = true;
+    } else if (option == "-e") {
+      equivalence = true;
+    } else if (option == "-u") {
+      universality = true;
+    } else if (option == "-m" && argc > 2) {
+      manifest = argv[2];
+      --argc;
+      ++argv;
+    } else if (option == "-g" && argc > 2) {
+      grow = argv[2];
+      --argc;
+      ++argv;
+    } else if (option == "-j" && argc > 2) {
+      opt.threads = stoul(argv[2]);
+      --argc;
+      ++argv;
+    } else if (option == "-s" && argc > 2) {
+      string order(argv[2]);
+      if (order == "dfs") {
+        opt.order = Limi::search_order::depth_first;
+      } else if (order == "bfs") {
+        opt.order = Limi::search_order::breadth_first;
+      } else if (order == "small") {
+        opt.order = Limi::search_order::smallest_first;
+      } else {
+        cerr << "Unknown search order " << order << endl;
+        return 1;
+      }
+      --argc;
+      ++argv;
+    } else {
+      cerr << "Unknown option " << option << endl;
+      return 1;
+    }
+    --argc;
+    ++argv;
+  }
+  if (!manifest.empty() && !universality && argc == 1)
+    return run_batch(manifest, reduce, equivalence, opt);
+  if (universality && argc == 2 && manifest.empty()) {
+    timbuk::symbol_table st;
+    cout << "Parsing" << endl;
+    timbuk::parsed_automaton aut(st,argv[1]);
+    timbuk::automaton auti(aut);
+    cout << "Universality check..." << endl;
+    auto start = chrono::steady_clock::now();
+    Limi::inclusion_result<timbuk::symbol> result;
+    if (reduce) {
+      auto reduced = Limi::reduce(auti);
+      cout << "Reduced to " << reduced->size() << " states" << endl;
+      result = universal(*reduced, st, opt);
+    } else {
+      result = universal(auti, st, opt);
+    }
+    auto stop = chrono::steady_clock::now();
+    cout << (result.included ? "Universal" : "Not Universal") << endl;
+    for (const timbuk::symbol& s : result.counter_example)
+      cout << auti.symbol_printer()(s) << endl;
+    chrono::milliseconds passed = std::chrono::duration_cast<chrono::milliseconds>(stop - start);
+    cout << "TIME: " << std::setprecision(3) << std::fixed << (double)passed.count()/1000 << " s" << endl;
+    return 0;
+  }
+  if (argc < 3 || universality || !manifest.empty()) {
+    cerr << "Two arguments are needed: The two automata to compare (or one with -u)." << endl;
+    cerr << "Usage: timbuk [-r] [-b] [-c] [-e] [-j threads] [-s dfs|bfs|small] A B" << endl;
+    cerr << "       timbuk -u [-r] [-s dfs|bfs|small] B" << endl;
+    cerr << "       timbuk -g more [-s dfs|bfs|small] A B" << endl;
+    cerr << "       timbuk -m manifest [-r] [-b] [-c] [-e] [-j threads] [-s dfs|bfs|small]" << endl;
     return 1;
   }
   string filename(argv[1]);
@@ -79,17 +205,42 @@ int main_wrapped(int argc, const char **argv) {
   //Limi::print_dot(auti, out);
   //out.close();
   
+  if (!grow.empty())
+    return run_grow(aut, auti, auti2, grow, st, reduce || equivalence, opt);
+  
+  if (equivalence) {
+    cout << "Language equivalence check..." << endl;
+    auto start = chrono::steady_clock::now();
+    Limi::equivalence_result<timbuk::symbol> result;
+    if (reduce) {
+      auto reduced = Limi::reduce(auti);
+      auto reduced2 = Limi::reduce(auti2);
+      cout << "Reduced to " << reduced->size() << " and " << reduced2->size() << " states" << endl;
+      result = equivalent(*reduced, *reduced2, st, opt);
+    } else {
+      result = equivalent(auti, auti2, st, opt);
+    }
+    auto stop = chrono::steady_clock::now();
+    result.print_long(cout, auti.symbol_printer());
+    chrono::milliseconds passed = std::chrono::duration_cast<chrono::milliseconds>(stop - start);
+    cout << "TIME: " << std::setprecision(3) << std::fixed << (double)passed.count()/1000 << " s" << endl;
+    return 0;
+  }
+  
   cout << "Language inclusion check..." << endl;
   
   // time measuring stuff
   auto start = chrono::steady_clock::now();
   
   Limi::inclusion_result<timbuk::symbol> result;
-  // if the independence relation is empty use the faster classic antichain algorithm algorithm 
-  if (st.independence_empty()) {
-    result = compare_no_independence(auti, auti2);
+  if (reduce) {
+    // the reduced automata have the same language but (usually) fewer states
+    auto reduced = Limi::reduce(auti);
+    auto reduced2 = Limi::reduce(auti2);
+    cout << "Reduced to " << reduced->size() << " and " << reduced2->size() << " states" << endl;
+    result = compare(*reduced, *reduced2, st, opt);
   } else {
-    result = compare_with_independence(auti, auti2, st);
+    result = compare(auti, auti2, st, opt);
   }
 
   auto stop = chrono::steady_clock::now();
@@ -99,13 +250,187 @@ int main_wrapped(int argc, const char **argv) {
   
   chrono::milliseconds passed = std::chrono::duration_cast<chrono::milliseconds>(stop - start);
   cout << "TIME: " << std::setprecision(3) << std::fixed << (double)passed.count()/1000 << " s" << endl;
+  return 0;
+}
+
+/**
+ * @brief Checks every pair of automata listed in the manifest
+ * 
+ * Every line of the manifest holds the paths of two automata A and B (empty lines and lines starting with # are skipped).
+ * Every file is parsed once, even if it takes part in several pairs, and all files share one symbol table.
+ * Like for a single pair the independence relations of all files are merged.
+ * The pairs are checked by a pool of opt.threads threads (0 = one per core) with the sequential algorithms and
+ * one line is printed per pair as soon as its check is done: the number of the pair, both paths, the result, 
+ * the time and the counter-example (if any).
+ */
+int run_batch(const string& manifest, bool reduce, bool equivalence, const options& opt) {
+  ifstream in(manifest);
+  if (!in)
+    throw runtime_error("File " + manifest + " not accessible");
+  vector<std::pair<string, string>> pairs;
+  string line;
+  for (unsigned number = 1; getline(in, line); ++number) {
+    istringstream fields(line);
+    string file_a, file_b, rest;
+    if (!(fields >> file_a) || file_a[0] == '#')
+      continue;
+    if (!(fields >> file_b) || (fields >> rest))
+      throw runtime_error("Line " + to_string(number) + " of " + manifest + " does not contain two files");
+    pairs.push_back(make_pair(file_a, file_b));
+  }
+  
+  // parse every file once
+  timbuk::symbol_table st;
+  unordered_map<string, unsigned> index;
+  vector<unique_ptr<timbuk::parsed_automaton>> parsed;
+  vector<unique_ptr<timbuk::automaton>> automata;
+  vector<unique_ptr<Limi::explicit_automaton<timbuk::state, timbuk::symbol>>> reduced;
+  vector<std::pair<unsigned, unsigned>> checks;
+  for (const auto& p : pairs) {
+    unsigned ids[2];
+    const string* files[2] = { &p.first, &p.second };
+    for (unsigned i = 0; i < 2; ++i) {
+      auto it = index.find(*files[i]);
+      if (it == index.end()) {
+        parsed.emplace_back(new timbuk::parsed_automaton(st, *files[i]));
+        automata.emplace_back(new timbuk::automaton(*parsed.back()));
+        // the printers are created on first use, which must not happen in the threads
+        automata.back()->state_printer();
+        automata.back()->symbol_printer();
+        if (reduce) {
+          reduced.push_back(Limi::reduce(*automata.back()));
+          reduced.back()->state_printer();
+          reduced.back()->symbol_printer();
+        }
+        it = index.insert(make_pair(*files[i], parsed.size() - 1)).first;
+      }
+      ids[i] = it->second;
+    }
+    checks.push_back(make_pair(ids[0], ids[1]));
+  }
+  
+  options sequential = opt;
+  sequential.threads = 1;
+  atomic<unsigned> next(0);
+  mutex out_mutex;
+  auto work = [&]() {
+    for (unsigned i = next++; i < checks.size(); i = next++) {
+      const timbuk::automaton& a = *automata[checks[i].first];
+      auto start = chrono::steady_clock::now();
+      string result;
+      try {
+        if (reduce)
+          result = check_pair(*reduced[checks[i].first], *reduced[checks[i].second], st, sequential, equivalence);
+        else
+          result = check_pair(a, *automata[checks[i].second], st, sequential, equivalence);
+      } catch (std::exception& e) {
+        result = string("Exception thrown: ") + e.what();
+      }
+      auto stop = chrono::steady_clock::now();
+      chrono::milliseconds passed = std::chrono::duration_cast<chrono::milliseconds>(stop - start);
+      ostringstream out;
+      out << i + 1 << " " << pairs[i].first << " " << pairs[i].second << " " << std::setprecision(3) << std::fixed
+          << (double)passed.count()/1000 << " s " << result;
+      lock_guard<mutex> lock(out_mutex);
+      cout << out.str() << endl;
+    }
+  };
+  
+  unsigned threads = opt.threads ? opt.threads : max(1u, thread::hardware_concurrency());
+  vector<thread> pool;
+  for (unsigned i = 1; i < threads; ++i)
+    pool.emplace_back(work);
+  work();
+  for (thread& t : pool)
+    t.join();
+  return 0;
+}
+
+/**
+ * @brief Checks if A is included in B, then adds the automaton in the file grow to A and resumes the check
+ * 
+ * Both results are printed. The second check only explores the pairs of the states of A that changed and the
+ * pairs that were not explored yet (see \ref Limi::antichain_algo::states_changed()).
+ */
+int run_grow(timbuk::parsed_automaton& aut, const timbuk::automaton& a, const timbuk::automaton& b, const string& grow, timbuk::symbol_table& st, bool other_check, const options& opt) {
+  if (other_check || opt.backward || opt.congruence || opt.threads != 1 || !st.independence_empty())
+    throw runtime_error("-g only works with the sequential antichain algorithm without reduction and independence relation");
+  cout << "Language inclusion check..." << endl;
+  Limi::antichain_algo<timbuk::automaton, timbuk::automaton> algo(a, b);
+  algo.set_search_order(opt.order);
+  algo.set_incremental(true);
+  algo.run().print_long(cout, a.symbol_printer());
+  
+  timbuk::parsed_automaton more(st, grow);
+  if (!st.independence_empty())
+    throw runtime_error("-g does not support independence relations");
+  timbuk::parsed_automaton::state_vector changed;
+  aut.add_all(more, changed);
+  cout << "Added " << grow << " to A (" << changed.size() << " states changed)" << endl;
+  algo.states_changed(changed);
+  algo.run().print_long(cout, a.symbol_printer());
+  return 0;
+}
+
+/**
+ * @brief Checks one pair of the batch and returns the result in one line
+ */
+template <class AutomatonA, class AutomatonB>
+string check_pair(const AutomatonA& a, const AutomatonB& b, const timbuk::symbol_table& st, const options& opt, bool equivalence) {
+  ostringstream out;
+  vector<timbuk::symbol> counter_example;
+  if (equivalence) {
+    auto result = equivalent(a, b, st, opt);
+    if (result.equivalent)
+      out << "Equivalent";
+    else
+      out << "Not Equivalent; " << (result.in_a ? "A not included in B" : "B not included in A");
+    counter_example = result.counter_example;
+  } else {
+    auto result = compare(a, b, st, opt);
+    if (result.included)
+      out << "Included";
+    else
+      out << "Not Included";
+    counter_example = result.counter_example;
+  }
+  for (const timbuk::symbol& s : counter_example)
+    out << " " << a.symbol_printer()(s);
+  return out.str();
+}
+
+/**
+ * @brief Runs the language inclusion algorithm that fits the independence relation
+ */
+template <class AutomatonA, class AutomatonB>
+Limi::inclusion_result<timbuk::symbol> compare(const AutomatonA& a, const AutomatonB& b, const timbuk::symbol_table& st, const options& opt) {
+  // if the independence relation is empty use the faster classic antichain algorithm algorithm 
+  if (st.independence_empty())
+    return compare_no_independence(a, b, opt);
+  return compare_with_independence(a, b, st, opt);
 }
 
 /**
  * @brief Runs the algorithm without independence relation. Faster if no independence relation is required.
  */
-Limi::inclusion_result<timbuk::symbol> compare_no_independence(const timbuk::automaton& a, const timbuk::automaton& b) {
-  auto algo = Limi::antichain_algo<timbuk::automaton,timbuk::automaton>(a, b);
+template <class AutomatonA, class AutomatonB>
+Limi::inclusion_result<timbuk::symbol> compare_no_independence(const AutomatonA& a, const AutomatonB& b, const options& opt) {
+  if (opt.backward) {
+    Limi::antichain_algo_backward<AutomatonA,AutomatonB> algo(a, b);
+    algo.set_search_order(opt.order);
+    return algo.run();
+  }
+  if (opt.congruence) {
+    Limi::congruence_algo<AutomatonA,AutomatonB> algo(a, b);
+    algo.set_search_order(opt.order);
+    return algo.run();
+  }
+  if (opt.threads != 1) {
+    Limi::parallel_antichain_algo<AutomatonA,AutomatonB> algo(a, b, opt.threads);
+    return algo.run();
+  }
+  auto algo = Limi::antichain_algo<AutomatonA,AutomatonB>(a, b);
+  algo.set_search_order(opt.order);
   return algo.run();
 }
 
@@ -114,8 +439,78 @@ Limi::inclusion_result<timbuk::symbol> compare_no_independence(const timbuk::aut
  * 
  * @return Guarantees that the trace is not spurious
  */
-Limi::inclusion_result<timbuk::symbol> compare_with_independence(const timbuk::automaton& a, const timbuk::automaton& b, const timbuk::symbol_table& st) {
-  auto algo = Limi::antichain_algo_ind<timbuk::automaton,timbuk::automaton>(a, b, initial_bound, Limi::independence<timbuk::symbol>(st));
+template <class AutomatonA, class AutomatonB>
+Limi::inclusion_result<timbuk::symbol> compare_with_independence(const AutomatonA& a, const AutomatonB& b, const timbuk::symbol_table& st, const options& opt) {
+  if (opt.backward)
+    throw runtime_error("The backward algorithm does not support independence relations");
+  if (opt.congruence)
+    throw runtime_error("The congruence algorithm does not support independence relations");
+  // the algorithms keep a reference to the independence relation
+  Limi::independence<timbuk::symbol> independence(st);
+  if (opt.threads != 1) {
+    Limi::parallel_antichain_algo_ind<AutomatonA,AutomatonB> algo(a, b, initial_bound, independence, opt.threads);
+    return run_with_bound(algo, a, b, st);
+  }
+  auto algo = Limi::antichain_algo_ind<AutomatonA,AutomatonB>(a, b, initial_bound, independence);
+  algo.set_search_order(opt.order);
+  return run_with_bound(algo, a, b, st);
+}
+
+/**
+ * @brief Checks both inclusions in one run (only without independence relation)
+ */
+template <class AutomatonA, class AutomatonB>
+Limi::equivalence_result<timbuk::symbol> equivalent(const AutomatonA& a, const AutomatonB& b, const timbuk::symbol_table& st, const options& opt) {
+  if (!st.independence_empty())
+    throw runtime_error("The equivalence check does not support independence relations");
+  Limi::equivalence_algo<AutomatonA,AutomatonB> algo(a, b);
+  algo.set_search_order(opt.order);
+  return algo.run();
+}
+
+/**
+ * @brief Checks if the automaton accepts every word (only without independence relation)
+ * 
+ * Every word of a timbuk automaton starts with a constant (like start()), the other symbols have one argument.
+ * The constants are taken to be the symbols on the transitions from the initial states. For every constant the
+ * automaton must accept all words over the other symbols from the successors of the initial states.
+ */
+template <class Automaton>
+Limi::inclusion_result<timbuk::symbol> universal(const Automaton& b, const timbuk::symbol_table& st, const options& opt) {
+  if (!st.independence_empty())
+    throw runtime_error("The universality check does not support independence relations");
+  typename Automaton::State_set initial;
+  b.initial_states(initial);
+  typename Automaton::Symbol_set constants;
+  for (const auto& state : initial)
+    b.next_symbols(state, constants);
+  if (constants.empty())
+    throw runtime_error("The automaton has no transitions from its initial states");
+  vector<timbuk::symbol> alphabet;
+  for (unsigned s = 0; s < st.size(); ++s) {
+    if (constants.find(s) == constants.end())
+      alphabet.push_back(s);
+  }
+  Limi::inclusion_result<timbuk::symbol> result;
+  for (const timbuk::symbol& constant : constants) {
+    Limi::universality_algo<Automaton> algo(b, b.successors(initial, constant), alphabet);
+    algo.set_search_order(opt.order);
+    result = algo.run();
+    if (!result.included) {
+      result.counter_example.insert(result.counter_example.begin(), constant);
+      return result;
+    }
+  }
+  return result;
+}
+
+/**
+ * @brief Increases the bound of the algorithm until the result is not spurious
+ * 
+ * The counter-examples are checked with the sequential algorithm.
+ */
+template <class Algorithm, class AutomatonA, class AutomatonB>
+Limi::inclusion_result<timbuk::symbol> run_with_bound(Algorithm& algo, const AutomatonA& a, const AutomatonB& b, const timbuk::symbol_table& st) {
   // limit the loop to some arbitrary boundary you can fix
   // in general the algorithm may diverge
   while (algo.get_bound() < max_bound) {
@@ -133,7 +528,8 @@ Limi::inclusion_result<timbuk::symbol> compare_with_independence(const timbuk::a
     {
       Limi::list_automaton<timbuk::symbol> ctex_automaton(result.counter_example.begin(), result.counter_example.end(), a.symbol_printer());
       // we use a starting bound of the length of the counter-example
-      Limi::antichain_algo_ind<Limi::list_automaton<timbuk::symbol>,timbuk::automaton> algo_check(ctex_automaton, b, result.counter_example.size(),  Limi::independence<timbuk::symbol>(st));
+      Limi::independence<timbuk::symbol> independence(st);
+      Limi::antichain_algo_ind<Limi::list_automaton<timbuk::symbol>,AutomatonB> algo_check(ctex_automaton, b, result.counter_example.size(), independence);
       auto check_res = algo_check.run();
       assert (!check_res.bound_hit); // this should never happen because the bound has the length of the trace
       if (!check_res.included)
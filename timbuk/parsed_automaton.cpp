@@ -24,6 +24,7 @@
 #include <stdexcept>
 #include <iostream>
 #include <fstream>
+#include <algorithm>
 
 using namespace timbuk;
 
@@ -79,6 +80,8 @@ state parsed_automaton::add_state(const string& name)
   names.push_back(name);
   successors_.push_back(successor_vector());
   symbols_.push_back(symbol_vector());
+  predecessors_.push_back(successor_vector());
+  prev_symbols_.push_back(symbol_vector());
   final_.push_back(false);
   state s = names.size()-1;
   lookup_.insert(make_pair(name, s));
@@ -101,6 +104,41 @@ void parsed_automaton::mark_final(state s)
   final_[s] = true;
 }
 
+/**
+ * @brief Adds the states, transitions and final states of another automaton
+ * 
+ * States with the same name are identified. Transitions and final states that are already there are skipped.
+ * 
+ * @param other An automaton that uses the same symbol table
+ * @param changed The states that got new outgoing transitions or became final are added to this vector
+ */
+void parsed_automaton::add_all(const parsed_automaton& other, state_vector& changed)
+{
+  state_vector here;
+  for (const string& name : other.names) {
+    auto it = lookup_.find(name);
+    here.push_back(it == lookup_.end() ? add_state(name) : it->second);
+  }
+  for (uint32_t s = 0; s < other.names.size(); ++s) {
+    bool change = false;
+    for (const auto& transitions : other.successors_[s]) {
+      for (state successor : transitions.second) {
+        const state_vector& existing = successors_[here[s]][transitions.first];
+        if (std::find(existing.begin(), existing.end(), here[successor]) != existing.end())
+          continue;
+        add_successor(here[s], transitions.first, here[successor]);
+        change = true;
+      }
+    }
+    if (other.final_[s] && !final_[here[s]]) {
+      mark_final(here[s]);
+      change = true;
+    }
+    if (change)
+      changed.push_back(here[s]);
+  }
+}
+
 state parsed_automaton::find(string name)
 {
   auto it = lookup_.find(name);
@@ -113,6 +151,10 @@ void parsed_automaton::add_successor(state s, symbol transition_symbol, state su
 {
   successors_[s][transition_symbol].push_back(successor);
   symbols_[s].push_back(transition_symbol);
+  state_vector& predecessors = predecessors_[successor][transition_symbol];
+  if (predecessors.empty())
+    prev_symbols_[successor].push_back(transition_symbol);
+  predecessors.push_back(s);
 }
 
 void parsed_automaton::add_successor(string s, string transition_symbol, string successor)
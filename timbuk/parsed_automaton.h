@@ -88,6 +88,7 @@ public:
   void add_successor(state s, symbol symbol, state successor);
   void mark_final(std::string s);
   void mark_final(state s);
+  void add_all(const parsed_automaton& other, state_vector& changed);
   
   inline const std::string name(state s) const { return names[s]; }
   inline void symbols(state s, symbol_vector& symbols) const { symbols.insert(symbols.end(), symbols_[s].begin(), symbols_[s].end()); }
@@ -97,7 +98,19 @@ public:
     if (it == ss.end()) return;
     successors.insert(successors.end(), it->second.begin(), it->second.end());
   }
+  inline void prev_symbols(state s, symbol_vector& symbols) const { symbols.insert(symbols.end(), prev_symbols_[s].begin(), prev_symbols_[s].end()); }
+  inline void predecessors(state s, symbol sigma, state_vector& predecessors) const { 
+    const successor_vector& ps = predecessors_[s]; 
+    auto it = ps.find(sigma);
+    if (it == ps.end()) return;
+    predecessors.insert(predecessors.end(), it->second.begin(), it->second.end());
+  }
   inline bool is_final(state s) const { return final_[s]; }
+  inline void final_states(state_vector& states) const {
+    for (uint32_t s = 0; s < final_.size(); ++s) {
+      if (final_[s]) states.push_back(s);
+    }
+  }
   
   inline const state_vector& initial() const { return initial_; }
   
@@ -114,6 +127,10 @@ private:
   std::vector<successor_vector> successors_;
   // list of successors symbols (on the edges to the successors)
   std::vector<symbol_vector> symbols_;
+  // list of predecessors for the state (vector index)
+  std::vector<successor_vector> predecessors_;
+  // list of predecessor symbols (on the edges from the predecessors)
+  std::vector<symbol_vector> prev_symbols_;
   // true if it is a final state
   std::vector<bool> final_;
   // set of initial states
@@ -137,6 +154,17 @@ namespace Limi {
   private:
     const timbuk::parsed_automaton& automaton_;
   };
+  
+  /**
+   * @brief States are numbered from 0 upwards.
+   * 
+   * This allows the antichain to store sets of states as bitsets.
+   * 
+   */
+  template<> struct dense_index<timbuk::state> {
+    static constexpr bool value = true;
+    static inline size_t index(const timbuk::state& state) { return state.s; }
+  };
 }
 
 
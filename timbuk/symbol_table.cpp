@@ -58,7 +58,7 @@ void symbol_table::add_independence(string name1, string name2)
   independence_.insert(p2);
 }
 
-bool symbol_table::independence_empty()
+bool symbol_table::independence_empty() const
 {
   return independence_.empty();
 }
@@ -85,7 +85,11 @@ public:
     // the test simply looks this up in a list of all independent symbols
     return (independence_.find(std::make_pair(a,b))!=independence_.end());
   }
-  bool independence_empty();
+  bool independence_empty() const;
+  /**
+   * @brief The number of symbols. The symbols are numbered from 0 to size()-1.
+   */
+  inline unsigned size() const { return symbols_.size(); }
 };
 }
 